@@ -0,0 +1,140 @@
+#ifndef BENCH_ARGS_HPP
+#define BENCH_ARGS_HPP
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Command line of a bench executable: positional arguments plus `--name
+// VALUE` options and `--name` flags, in any order. A bench points each one
+// at a field of its config, calls parse(), then checks the values itself.
+class BenchArgs {
+public:
+    // A required positional argument, shown as `<metavar>`.
+    void positional(const char* metavar, std::string &out) {
+        m_positionals.push_back(Positional{metavar, &out});
+    }
+    // Every positional argument after the declared ones; at least one is
+    // required. Shown as `<metavar>...`.
+    void rest(const char* metavar, std::vector<std::string> &out) {
+        m_restName = metavar;
+        m_rest = &out;
+    }
+    // `name VALUE`, converted to T.
+    template<typename T>
+    void option(const char* name, const char* metavar, T &out) {
+        m_options.push_back(Option{name, metavar, [&out](const char* value) { return convert(value, out); }});
+    }
+    // `name` alone sets `out`.
+    void flag(const char* name, bool &out) {
+        m_options.push_back(Option{name, "", [&out](const char*) { out = true; return true; }});
+    }
+
+    // False on an unknown option, a missing value or positional argument,
+    // a value that is not a whole number of the option's type, or one too
+    // many positional arguments.
+    bool parse(int argc, char* argv[]) const {
+        size_t positional = 0;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) == 0) {
+                const Option* option = find(arg);
+                if (!option)
+                    return false;
+                if (option->metavar.empty()) {
+                    option->set(nullptr);
+                    continue;
+                }
+                if (i + 1 >= argc || !option->set(argv[++i]))
+                    return false;
+            } else if (positional < m_positionals.size()) {
+                *m_positionals[positional++].out = arg;
+            } else if (m_rest) {
+                m_rest->push_back(arg);
+            } else {
+                return false;
+            }
+        }
+        return positional == m_positionals.size() && (!m_rest || !m_rest->empty());
+    }
+
+    void printUsage(const char* prog) const {
+        std::cerr << "Usage: " << prog;
+        for (const Positional &p : m_positionals)
+            std::cerr << " <" << p.metavar << ">";
+        if (m_rest)
+            std::cerr << " <" << m_restName << ">...";
+        for (const Option &o : m_options) {
+            std::cerr << " [" << o.name;
+            if (!o.metavar.empty())
+                std::cerr << " " << o.metavar;
+            std::cerr << "]";
+        }
+        std::cerr << "\n";
+    }
+
+private:
+    struct Positional {
+        std::string metavar;
+        std::string* out;
+    };
+    struct Option {
+        std::string name;
+        std::string metavar;    // empty for a flag
+        std::function<bool(const char*)> set;
+    };
+
+    // Leaves `out` alone unless all of `value` converts and fits in T.
+    template<typename T>
+    static bool convert(const char* value, T &out) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            out = value;
+            return true;
+        } else {
+            char* end = nullptr;
+            errno = 0;
+            if constexpr (std::is_floating_point_v<T>) {
+                double v = std::strtod(value, &end);
+                if (end == value || *end != '\0' || errno != 0)
+                    return false;
+                out = static_cast<T>(v);
+            } else if constexpr (std::is_signed_v<T>) {
+                long long v = std::strtoll(value, &end, 10);
+                if (end == value || *end != '\0' || errno != 0 ||
+                    v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+                    return false;
+                out = static_cast<T>(v);
+            } else {
+                // strtoull takes "-1" as the largest value.
+                if (std::strchr(value, '-'))
+                    return false;
+                unsigned long long v = std::strtoull(value, &end, 10);
+                if (end == value || *end != '\0' || errno != 0 || v > std::numeric_limits<T>::max())
+                    return false;
+                out = static_cast<T>(v);
+            }
+            return true;
+        }
+    }
+
+    const Option* find(const std::string &name) const {
+        for (const Option &o : m_options) {
+            if (o.name == name)
+                return &o;
+        }
+        return nullptr;
+    }
+
+    std::vector<Positional> m_positionals;
+    std::string m_restName;
+    std::vector<std::string>* m_rest = nullptr;
+    std::vector<Option> m_options;
+};
+
+#endif // BENCH_ARGS_HPP
@@ -0,0 +1,172 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Game/IGame.hpp"
+#include "Network/Protocol/Protocol.hpp"
+#include "Network/Protocol/SnapshotDelta.hpp"
+#include "Network/Server/Globals.hpp"
+#include "Network/Server/InterestManager.hpp"
+#include "Network/Server/NetworkUtils.hpp"
+#include "BenchArgs.hpp"
+
+// Runs a plugin with a session per player and sends every tick's snapshot
+// through broadcastGameState, as the server's send stage does. Reports how
+// often a client's interest mask keeps the whole snapshot and how often it
+// got the shared encoding, and fails if any client whose mask kept
+// everything got a copy of its own instead.
+
+struct BenchConfig {
+    std::string pluginPath;
+    int players = 4;
+    int ticks = 400;
+    float dt = 0.05f;
+    // Large enough by default that the priority packing never holds an
+    // entity back, which would also (rightly) take a client off the shared
+    // snapshot.
+    size_t budget = maxReassembledSize;
+
+    bool valid() const {
+        return players > 0 && players <= static_cast<int>(maxSnapshotPlayers) && ticks > 0 && dt > 0.f &&
+               budget > 0;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    BenchArgs args;
+    args.positional("plugin.so", cfg.pluginPath);
+    args.option("--players", "N", cfg.players);
+    args.option("--ticks", "N", cfg.ticks);
+    args.option("--dt", "SECONDS", cfg.dt);
+    args.option("--budget", "BYTES", cfg.budget);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return 1;
+    }
+
+    void* handle = dlopen(cfg.pluginPath.c_str(), RTLD_NOW);
+    if (!handle) {
+        std::cerr << "[Bench] Failed to load plugin: " << dlerror() << "\n";
+        return 1;
+    }
+    dlerror();
+    typedef IGame* (*createGame_t)();
+    createGame_t createGame = (createGame_t)dlsym(handle, "createGame");
+    const char* dlsym_error = dlerror();
+    if (dlsym_error) {
+        std::cerr << "[Bench] Cannot load symbol 'createGame': " << dlsym_error << "\n";
+        dlclose(handle);
+        return 1;
+    }
+    IGame* game = createGame();
+    if (!game) {
+        std::cerr << "[Bench] Failed to create game instance.\n";
+        dlclose(handle);
+        return 1;
+    }
+
+    // Snapshots really go out, to loopback ports nobody listens on.
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        std::cerr << "[Bench] socket failed.\n";
+        return 1;
+    }
+    serverSocket.open(sock, SocketBackend::Batched);
+
+    std::vector<int32_t> netIDs;
+    for (int i = 0; i < cfg.players; i++) {
+        int32_t id = 50000 + i;
+        netIDs.push_back(id);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(id));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool created = false;
+        ClientSession* session = connections.findOrInsert(addr, created);
+        session->hasPlayer = true;
+        session->playerID = id;
+        session->snapshotBudget = cfg.budget;
+    }
+
+    SnapshotRing history;
+    InterestManager interest(*game);
+    std::vector<PlayerInputPayload> batch;
+    uint64_t sent = 0, allRelevant = 0, shared = 0, failures = 0;
+
+    game->onStart();
+    for (int tick = 0; tick < cfg.ticks; tick++) {
+        batch.clear();
+        for (int32_t id : netIDs) {
+            PlayerInputPayload in{};
+            in.netID = id;
+            in.tick = static_cast<uint32_t>(tick + 1);
+            int leg = ((tick + id * 7) / 20) % 4;
+            in.up = leg == 0;
+            in.right = leg == 1;
+            in.down = leg == 2;
+            in.left = leg == 3;
+            in.shoot = (tick + id) % 5 == 0;
+            batch.push_back(in);
+        }
+        game->onPlayerInputs(batch.data(), batch.size());
+        game->onUpdate(cfg.dt);
+        GameStatePayload payload = game->getGameState().payload;
+
+        uint32_t sequence = static_cast<uint32_t>(tick + 1);
+        history.store(sequence, payload);
+        SnapshotTime time{sequence, 0};
+        broadcastGameState(payload, sequence, time, nullptr, 0, history, interest);
+        flushSessions();
+
+        // Indexed with this tick's snapshot by broadcastGameState.
+        for (ClientSession &session : connections) {
+            bool isShared = false;
+            if (!session.findSnapshot(sequence, history, isShared))
+                continue;
+            SnapshotMask mask;
+            InterestArea area;
+            interest.select(session.hasPlayer, session.playerID, mask, area);
+            sent++;
+            if (isShared)
+                shared++;
+            if (!mask.everything)
+                continue;
+            allRelevant++;
+            if (!isShared) {
+                if (failures++ == 0)
+                    std::cerr << "[Bench] Tick " << sequence << ": player " << session.playerID
+                              << " saw everything but got its own snapshot.\n";
+            }
+        }
+    }
+
+    auto percent = [&](uint64_t n) { return sent ? 100.0 * static_cast<double>(n) / static_cast<double>(sent) : 0.0; };
+    std::cout << "[Bench] plugin=" << cfg.pluginPath << " players=" << cfg.players << " ticks=" << cfg.ticks
+              << " budget=" << cfg.budget << "\n";
+    std::cout << "[Bench] " << sent << " snapshots sent, " << std::fixed << std::setprecision(1)
+              << percent(allRelevant) << "% with every entity relevant, " << percent(shared)
+              << "% shared\n";
+
+    delete game;
+    close(sock);
+    dlclose(handle);
+    if (failures) {
+        std::cerr << "[Bench] " << failures << " all-relevant snapshots were not shared.\n";
+        return 1;
+    }
+    if (allRelevant == 0) {
+        std::cerr << "[Bench] No snapshot kept every entity; nothing was checked.\n";
+        return 1;
+    }
+    return 0;
+}
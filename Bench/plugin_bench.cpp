@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <dlfcn.h>
+
+#include "Game/IGame.hpp"
+#include "Network/Protocol/Protocol.hpp"
+#include "BenchArgs.hpp"
+
+// Headless driver for IGame plugins: loads a plugin, feeds it synthetic
+// player inputs and times each phase of a server tick with no sockets involved.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::string pluginPath;
+    int players = 4;
+    int ticks = 10000;
+    float dt = 0.05f;
+    unsigned int seed = 42;
+    bool scripted = false;
+    std::string recordPath;
+
+    bool valid() const {
+        return players > 0 && ticks > 0 && dt > 0.f;
+    }
+};
+
+struct PhaseTimings {
+    const char* name;
+    std::vector<int64_t> samples;
+};
+
+// Scripted inputs sweep each player around a square and fire every few ticks,
+// so runs are reproducible across machines and plugin versions.
+static PlayerInputPayload scriptedInput(int32_t netID, int tick) {
+    PlayerInputPayload in{};
+    in.netID = netID;
+    int leg = ((tick + netID * 7) / 20) % 4;
+    in.up    = (leg == 0);
+    in.right = (leg == 1);
+    in.down  = (leg == 2);
+    in.left  = (leg == 3);
+    in.shoot = ((tick + netID) % 5 == 0);
+    return in;
+}
+
+static PlayerInputPayload randomInput(int32_t netID, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> bit(0, 1);
+    std::uniform_int_distribution<int> fire(0, 3);
+    PlayerInputPayload in{};
+    in.netID = netID;
+    in.up    = bit(rng);
+    in.down  = !in.up && bit(rng);
+    in.left  = bit(rng);
+    in.right = !in.left && bit(rng);
+    in.shoot = (fire(rng) == 0);
+    return in;
+}
+
+static int64_t percentile(std::vector<int64_t> sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    std::sort(sorted.begin(), sorted.end());
+    size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[idx];
+}
+
+static void printPhase(const PhaseTimings &phase) {
+    auto us = [](int64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    int64_t maxNs = phase.samples.empty() ? 0 :
+        *std::max_element(phase.samples.begin(), phase.samples.end());
+    std::cout << std::left << std::setw(8) << phase.name << std::right << std::fixed << std::setprecision(2)
+              << "  p50 " << std::setw(9) << us(percentile(phase.samples, 0.50)) << " us"
+              << "  p99 " << std::setw(9) << us(percentile(phase.samples, 0.99)) << " us"
+              << "  max " << std::setw(9) << us(maxNs) << " us\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    BenchArgs args;
+    args.positional("plugin.so", cfg.pluginPath);
+    args.option("--players", "N", cfg.players);
+    args.option("--ticks", "N", cfg.ticks);
+    args.option("--dt", "SECONDS", cfg.dt);
+    args.option("--seed", "N", cfg.seed);
+    args.flag("--scripted", cfg.scripted);
+    args.option("--record", "FILE", cfg.recordPath);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return 1;
+    }
+
+    void* handle = dlopen(cfg.pluginPath.c_str(), RTLD_NOW);
+    if (!handle) {
+        std::cerr << "[Bench] Failed to load plugin: " << dlerror() << "\n";
+        return 1;
+    }
+    dlerror();
+    typedef IGame* (*createGame_t)();
+    createGame_t createGame = (createGame_t)dlsym(handle, "createGame");
+    const char* dlsym_error = dlerror();
+    if (dlsym_error) {
+        std::cerr << "[Bench] Cannot load symbol 'createGame': " << dlsym_error << "\n";
+        dlclose(handle);
+        return 1;
+    }
+    IGame* game = createGame();
+    if (!game) {
+        std::cerr << "[Bench] Failed to create game instance.\n";
+        dlclose(handle);
+        return 1;
+    }
+
+    std::vector<int32_t> netIDs;
+    for (int i = 0; i < cfg.players; i++)
+        netIDs.push_back(50000 + i);
+
+    std::mt19937 rng(cfg.seed);
+    PhaseTimings input{"input", {}};
+    PhaseTimings update{"update", {}};
+    PhaseTimings state{"state", {}};
+    PhaseTimings total{"tick", {}};
+    input.samples.reserve(cfg.ticks);
+    update.samples.reserve(cfg.ticks);
+    state.samples.reserve(cfg.ticks);
+    total.samples.reserve(cfg.ticks);
+
+    auto ns = [](Clock::time_point a, Clock::time_point b) {
+        return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+    };
+
+    // The recording is the raw GameStatePayload of every tick, back to back,
+    // and is what snapshot_bench replays.
+    std::ofstream record;
+    if (!cfg.recordPath.empty()) {
+        record.open(cfg.recordPath, std::ios::binary);
+        if (!record) {
+            std::cerr << "[Bench] Cannot open " << cfg.recordPath << " for writing.\n";
+            delete game;
+            dlclose(handle);
+            return 1;
+        }
+    }
+
+    std::vector<PlayerInputPayload> batch;
+    batch.reserve(netIDs.size());
+
+    game->onStart();
+    size_t entitySum = 0;
+    auto benchStart = Clock::now();
+    for (int tick = 0; tick < cfg.ticks; tick++) {
+        auto t0 = Clock::now();
+        batch.clear();
+        for (int32_t id : netIDs)
+            batch.push_back(cfg.scripted ? scriptedInput(id, tick) : randomInput(id, rng));
+        game->onPlayerInputs(batch.data(), batch.size());
+        auto t1 = Clock::now();
+        game->onUpdate(cfg.dt);
+        auto t2 = Clock::now();
+        GameState gs = game->getGameState();
+        auto t3 = Clock::now();
+
+        entitySum += gs.payload.numPlayers + gs.payload.numEnemies + gs.payload.numBullets;
+        input.samples.push_back(ns(t0, t1));
+        update.samples.push_back(ns(t1, t2));
+        state.samples.push_back(ns(t2, t3));
+        total.samples.push_back(ns(t0, t3));
+        if (record.is_open())
+            record.write(reinterpret_cast<const char*>(&gs.payload), sizeof(GameStatePayload));
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - benchStart).count();
+
+    std::cout << "[Bench] plugin=" << cfg.pluginPath << " players=" << cfg.players
+              << " ticks=" << cfg.ticks << " dt=" << cfg.dt
+              << " inputs=" << (cfg.scripted ? "scripted" : "random") << "\n";
+    std::cout << "[Bench] " << std::fixed << std::setprecision(1)
+              << (static_cast<double>(cfg.ticks) / elapsed) << " ticks/sec, avg "
+              << (static_cast<double>(entitySum) / cfg.ticks) << " entities/snapshot\n";
+    printPhase(input);
+    printPhase(update);
+    printPhase(state);
+    printPhase(total);
+
+    delete game;
+    dlclose(handle);
+    return 0;
+}
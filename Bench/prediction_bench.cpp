@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Network/Protocol/Protocol.hpp"
+#include "Network/System/InputSampler.hpp"
+#include "Network/System/Prediction.hpp"
+#include "Game/RType/RTypeMovement.hpp"
+#include "BenchArgs.hpp"
+
+// Plays a scripted session of key presses through the client's input
+// sampling and prediction against a model of the server tick, over a
+// simulated link with the given round trip, and reports how long each key
+// takes to show on screen with prediction and without it (the ship drawn at
+// the last snapshot's position), how large the corrections are, and where
+// the ship ends up relative to the server.
+
+using Clock = LocalPrediction::Clock;
+
+struct BenchConfig {
+    int rttMs = 150;
+    int jitterMs = 0;
+    int seconds = 20;
+    unsigned int seed = 42;
+
+    bool valid() const {
+        return rttMs >= 0 && jitterMs >= 0 && jitterMs <= rttMs / 2 && seconds > 1;
+    }
+};
+
+struct Keys {
+    bool up, down, left, right;
+};
+
+// Half a second on each direction, half a second released in between; the
+// last second is released so the ship settles.
+static Keys scriptedKeys(int ms, int totalMs) {
+    static const Keys steps[] = {
+        {false, false, false, true},  {false, false, false, false},
+        {false, true, false, false},  {false, false, false, false},
+        {false, false, true, false},  {false, false, false, false},
+        {true, false, false, false},  {false, false, false, false},
+    };
+    if (ms >= totalMs - 1000)
+        return Keys{false, false, false, false};
+    return steps[(ms / 500) % (sizeof(steps) / sizeof(steps[0]))];
+}
+
+struct Snapshot {
+    int arrivesAt;
+    uint32_t sequence;
+    float x, y;
+    InputAckPayload ack;
+};
+
+struct InFlightInput {
+    int arrivesAt;
+    PlayerInputPayload input;
+};
+
+// Time from a key press to the first frame that moves the ship that way.
+// Releases are not timed: a ship drawn at snapshot positions stands still
+// between snapshots, which would pass for an instant stop.
+struct ResponseStats {
+    double totalMs = 0.0;
+    int count = 0;
+    int pendingSince = -1;
+    float wantX = 0.f, wantY = 0.f;
+
+    void onKeysChanged(int ms, const Keys &keys) {
+        wantX = (keys.right ? 1.f : 0.f) - (keys.left ? 1.f : 0.f);
+        wantY = (keys.down ? 1.f : 0.f) - (keys.up ? 1.f : 0.f);
+        pendingSince = (wantX != 0.f || wantY != 0.f) ? ms : -1;
+    }
+    void onFrame(int ms, float dx, float dy) {
+        if (pendingSince < 0)
+            return;
+        if (dx * wantX + dy * wantY <= 0.5f)
+            return;
+        totalMs += ms - pendingSince;
+        count++;
+        pendingSince = -1;
+    }
+    double mean() const { return count ? totalMs / count : 0.0; }
+};
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    BenchArgs args;
+    args.option("--rtt", "MS", cfg.rttMs);
+    args.option("--jitter", "MS", cfg.jitterMs);
+    args.option("--seconds", "N", cfg.seconds);
+    args.option("--seed", "N", cfg.seed);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return 1;
+    }
+
+    constexpr int frameMs = 16;
+    constexpr int tickMs = 1000 / serverTickRate;
+    const int totalMs = cfg.seconds * 1000;
+    const Clock::time_point start{};
+    auto clockAt = [&](int ms) { return start + std::chrono::milliseconds(ms); };
+
+    std::mt19937 rng(cfg.seed);
+    std::uniform_int_distribution<int> jitter(-cfg.jitterMs, cfg.jitterMs);
+    auto oneWay = [&]() { return cfg.rttMs / 2 + jitter(rng); };
+
+    // Server model: what runSimulation and broadcastGameState do for one player.
+    float serverX = 100.f, serverY = 300.f;
+    Keys held{};
+    uint32_t lastInputTick = 0;
+    bool hasApplied = false;
+    InputAckPayload applied{};
+    float appliedSeconds = 0.f;
+    uint32_t snapshotSequence = 0;
+    std::deque<InFlightInput> uplink;
+    std::vector<Snapshot> downlink;
+
+    // Client.
+    InputSampler sampler;
+    LocalPrediction prediction(RTypeMovement::movePlayer);
+    uint32_t inputTick = 0;
+    uint32_t lastSnapshot = 0;
+    float snapshotX = serverX, snapshotY = serverY;
+    float shownX = serverX, shownY = serverY;
+    float laggedX = serverX, laggedY = serverY;
+    Keys lastKeys{};
+
+    ResponseStats predicted, lagged;
+    double correctionSum = 0.0, correctionMax = 0.0;
+    int corrections = 0;
+
+    for (int ms = 0; ms <= totalMs; ms++) {
+        // Server tick.
+        if (ms % tickMs == 0) {
+            for (auto it = uplink.begin(); it != uplink.end();) {
+                if (it->arrivesAt > ms) {
+                    ++it;
+                    continue;
+                }
+                const PlayerInputPayload &in = it->input;
+                if (in.tick > lastInputTick) {
+                    lastInputTick = in.tick;
+                    held = Keys{in.up, in.down, in.left, in.right};
+                    hasApplied = true;
+                    applied.inputTick = in.tick;
+                    appliedSeconds = 0.f;
+                }
+                it = uplink.erase(it);
+            }
+            float dt = tickMs / 1000.f;
+            RTypeMovement::movePlayer(serverX, serverY, held.up, held.down, held.left, held.right, dt);
+            appliedSeconds += dt;
+            Snapshot s{ms + oneWay(), ++snapshotSequence, serverX, serverY, applied};
+            s.ack.snapshotSequence = s.sequence;
+            s.ack.heldMs = static_cast<uint32_t>(appliedSeconds * 1000.f + 0.5f);
+            if (!hasApplied)
+                s.ack.inputTick = 0;
+            downlink.push_back(s);
+        }
+
+        // Snapshots reaching the client.
+        for (auto it = downlink.begin(); it != downlink.end();) {
+            if (it->arrivesAt > ms) {
+                ++it;
+                continue;
+            }
+            if (it->sequence > lastSnapshot) {
+                lastSnapshot = it->sequence;
+                snapshotX = it->x;
+                snapshotY = it->y;
+                float x, y;
+                bool shown = prediction.position(clockAt(ms), x, y);
+                prediction.onServerState(it->x, it->y, it->ack.inputTick ? &it->ack : nullptr, clockAt(ms));
+                if (shown) {
+                    correctionSum += prediction.lastCorrection();
+                    correctionMax = std::max<double>(correctionMax, prediction.lastCorrection());
+                    corrections++;
+                }
+            }
+            it = downlink.erase(it);
+        }
+
+        // Client frame.
+        if (ms % frameMs == 0) {
+            Keys keys = scriptedKeys(ms, totalMs);
+            if (keys.up != lastKeys.up || keys.down != lastKeys.down ||
+                keys.left != lastKeys.left || keys.right != lastKeys.right) {
+                predicted.onKeysChanged(ms, keys);
+                lagged.onKeysChanged(ms, keys);
+                lastKeys = keys;
+            }
+            PlayerInputPayload now{};
+            now.netID = 1;
+            now.up = keys.up;
+            now.down = keys.down;
+            now.left = keys.left;
+            now.right = keys.right;
+            PlayerInputPayload sample;
+            if (sampler.update(frameMs / 1000.f, now, sample)) {
+                sample.tick = ++inputTick;
+                prediction.onInputSent(sample, clockAt(ms));
+                uplink.push_back(InFlightInput{ms + oneWay(), sample});
+            }
+
+            float x, y;
+            if (prediction.position(clockAt(ms), x, y)) {
+                predicted.onFrame(ms, x - shownX, y - shownY);
+                shownX = x;
+                shownY = y;
+            }
+            lagged.onFrame(ms, snapshotX - laggedX, snapshotY - laggedY);
+            laggedX = snapshotX;
+            laggedY = snapshotY;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "[Bench] rtt=" << cfg.rttMs << " ms jitter=" << cfg.jitterMs << " ms, "
+              << predicted.count << " key presses, frame " << frameMs << " ms, tick " << tickMs << " ms\n"
+              << "[Bench] perceived input latency: " << predicted.mean() << " ms predicted, "
+              << lagged.mean() << " ms without prediction\n"
+              << "[Bench] corrections: " << corrections << ", mean " << (corrections ? correctionSum / corrections : 0.0)
+              << " px, max " << correctionMax << " px\n"
+              << "[Bench] final position: predicted (" << shownX << "," << shownY << ") server ("
+              << serverX << "," << serverY << ")\n";
+    return std::hypot(shownX - serverX, shownY - serverY) < 1.f ? 0 : 1;
+}
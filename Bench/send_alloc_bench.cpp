@@ -0,0 +1,172 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "Network/Protocol/Protocol.hpp"
+#include "Network/Protocol/Reliability.hpp"
+#include "Network/Protocol/PacketBuilder.hpp"
+#include "Network/System/NetworkSystem.hpp"
+#include "BenchArgs.hpp"
+
+// Counts heap allocations on the client's send path in steady state.
+//
+// A NetworkSystem talks to a stand-in server on loopback that acks every
+// datagram, so reliable messages are released as they would be in a match.
+// After a warm-up the bench sends inputs, unreliable and reliable messages
+// and runs pump() in a loop, counting operator new calls made from the
+// sending thread; anything but zero is a failure.
+
+namespace {
+
+thread_local bool counting = false;
+std::atomic<uint64_t> allocations{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (counting)
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+struct BenchConfig {
+    int iterations = 20000;
+    int warmup = 500;
+
+    bool valid() const {
+        return iterations > 0 && warmup >= 0;
+    }
+};
+
+// Acks everything the client sends, with a bare ack per datagram.
+static void runServer(int sock, std::atomic<bool> &stop, std::atomic<uint64_t> &received) {
+    ReliableChannel channel;
+    PacketBuilder outgoing;
+    sockaddr_in peer{};
+    auto send = [&](const char* data, size_t len) {
+        return sendto(sock, data, len, 0, reinterpret_cast<sockaddr*>(&peer), sizeof(peer)) >= 0;
+    };
+    char buf[maxPacketSize];
+    while (!stop.load(std::memory_order_relaxed)) {
+        pollfd pfd{sock, POLLIN, 0};
+        if (poll(&pfd, 1, 10) <= 0)
+            continue;
+        socklen_t peerLen = sizeof(peer);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&peer), &peerLen);
+        if (len <= 0)
+            continue;
+        BitReader reader(buf, static_cast<size_t>(len));
+        PacketHeader packet;
+        if (!readPacketHeader(reader, packet))
+            continue;
+        auto now = ReliableChannel::Clock::now();
+        if (!channel.receive(packet, now))
+            continue;
+        received.fetch_add(1, std::memory_order_relaxed);
+        MessageFrameReader frames(buf, static_cast<size_t>(len), reader.bytesRead());
+        MessageHeader h;
+        const char* body = nullptr;
+        size_t bodyLen = 0;
+        while (frames.next(h, body, bodyLen)) {
+            if (h.flags & messageReliable)
+                channel.acceptReliable(h.reliableID);
+        }
+        channel.requestAck(now);
+        outgoing.flush(channel, send, true);
+    }
+}
+
+// One frame's worth of client traffic: an input, a PING-sized unreliable
+// message, now and then a reliable one, and the network thread's pump.
+static void sendRound(NetworkSystem &client, int i) {
+    PlayerInputPayload input{};
+    input.netID = 1;
+    input.right = (i / 30) % 2 == 0;
+    input.up = (i / 45) % 2 == 0;
+    client.sendInput(input);
+
+    PingPayload ping{};
+    ping.pingSequence = static_cast<uint32_t>(i);
+    ping.clientSendTime = getCurrentTimeMS();
+    client.sendPacket(static_cast<uint8_t>(MessageType::PING), &ping, sizeof(ping), false);
+
+    if (i % 16 == 0)
+        client.sendPacket(static_cast<uint8_t>(MessageType::READY), nullptr, 0, true);
+
+    client.pump();
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    BenchArgs args;
+    args.option("--iterations", "N", cfg.iterations);
+    args.option("--warmup", "N", cfg.warmup);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return 1;
+    }
+
+    int serverSock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addrLen = sizeof(addr);
+    if (serverSock < 0 || bind(serverSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        getsockname(serverSock, reinterpret_cast<sockaddr*>(&addr), &addrLen) < 0) {
+        std::cerr << "[Bench] Cannot bind the stand-in server socket.\n";
+        return 1;
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> received{0};
+    std::thread server(runServer, serverSock, std::ref(stop), std::ref(received));
+
+    int result = 0;
+    {
+        NetworkSystem client("127.0.0.1", ntohs(addr.sin_port), 0);
+
+        for (int i = 0; i < cfg.warmup; i++)
+            sendRound(client, i);
+
+        auto start = std::chrono::steady_clock::now();
+        counting = true;
+        for (int i = 0; i < cfg.iterations; i++)
+            sendRound(client, cfg.warmup + i);
+        counting = false;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t count = allocations.load();
+        std::cout << "[Bench] " << cfg.iterations << " rounds in " << seconds << " s, "
+                  << received.load() << " datagrams reached the server, packet loss "
+                  << client.getPacketLoss() << "\n"
+                  << "[Bench] heap allocations on the send path: " << count << "\n";
+        result = count == 0 ? 0 : 1;
+    }
+
+    stop = true;
+    server.join();
+    close(serverSock);
+    return result;
+}
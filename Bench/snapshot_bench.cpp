@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Network/Protocol/Protocol.hpp"
+#include "Network/Protocol/SnapshotDelta.hpp"
+#include "Network/Protocol/MessageCodec.hpp"
+#include "Network/Protocol/Fragmentation.hpp"
+#include "Network/Protocol/Compression.hpp"
+#include "BenchArgs.hpp"
+
+// Replays a match recorded with `plugin_bench --record` through the snapshot
+// encoder the server uses and reports the bytes each client would receive,
+// along with encode/decode cost per entity, and what compressing the bodies
+// the way the server does saves and costs per packet.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::string recordingPath;
+    int ackLag = 2;
+    double lossPercent = 0.0;
+    unsigned int seed = 42;
+
+    bool valid() const {
+        return ackLag >= 0 && lossPercent >= 0.0 && lossPercent < 100.0;
+    }
+};
+
+static std::vector<GameStatePayload> loadRecording(const std::string &path) {
+    std::vector<GameStatePayload> frames;
+    std::ifstream in(path, std::ios::binary);
+    GameStatePayload gs;
+    while (in.read(reinterpret_cast<char*>(&gs), sizeof(GameStatePayload)))
+        frames.push_back(gs);
+    return frames;
+}
+
+// Decoded snapshots come out sorted by id, so compare both sides in that order.
+static GameStatePayload canonical(GameStatePayload gs) {
+    std::sort(gs.players, gs.players + gs.numPlayers,
+              [](const auto &a, const auto &b) { return a.playerID < b.playerID; });
+    std::sort(gs.enemies, gs.enemies + gs.numEnemies,
+              [](const auto &a, const auto &b) { return a.enemyID < b.enemyID; });
+    std::sort(gs.bullets, gs.bullets + gs.numBullets,
+              [](const auto &a, const auto &b) { return a.bulletID < b.bulletID; });
+    return gs;
+}
+
+// Bytes a snapshot puts on the wire: packet header, message framing, and for
+// bodies that do not fit in one datagram, all of that plus the FRAGMENT
+// prefix once per fragment. The packet header is counted in full even though
+// a small snapshot shares its datagram with the other messages of the tick.
+static size_t framedSize(uint8_t type, size_t bodyLen) {
+    MessageHeader h{};
+    h.type = type;
+    h.flags = messageNeedsAck;
+    char header[maxMessageHeaderSize];
+    BitWriter w(header, sizeof(header));
+    writeMessageHeader(w, h, bodyLen);
+    return w.finish() + bodyLen;
+}
+
+static size_t wireBytes(uint8_t type, uint32_t seq, const char* body, size_t len) {
+    PacketHeader ph{seq, seq, ~0u};
+    char header[maxPacketHeaderSize];
+    BitWriter w(header, sizeof(header));
+    writePacketHeader(w, ph);
+    size_t packetHeaderLen = w.finish();
+    if (len <= maxMessageBody)
+        return packetHeaderLen + framedSize(type, len);
+    char fragment[maxMessageBody];
+    size_t total = 0;
+    for (size_t i = 0; i < fragmentCount(len); i++) {
+        size_t fragLen = encodeFragmentBody(seq, type, body, len, i, fragment, sizeof(fragment));
+        total += packetHeaderLen + framedSize(static_cast<uint8_t>(MessageType::FRAGMENT), fragLen);
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    BenchArgs args;
+    args.positional("recording", cfg.recordingPath);
+    args.option("--ack-lag", "TICKS", cfg.ackLag);
+    args.option("--loss", "PERCENT", cfg.lossPercent);
+    args.option("--seed", "N", cfg.seed);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return 1;
+    }
+    std::vector<GameStatePayload> frames = loadRecording(cfg.recordingPath);
+    if (frames.empty()) {
+        std::cerr << "[Bench] No snapshots in " << cfg.recordingPath << "\n";
+        return 1;
+    }
+
+    std::mt19937 rng(cfg.seed);
+    std::bernoulli_distribution dropped(cfg.lossPercent / 100.0);
+
+    SnapshotRing serverHistory;
+    SnapshotRing clientHistory;
+    uint32_t serverAcked = 0;
+    std::deque<std::pair<size_t, uint32_t>> acksInFlight;
+
+    // What the old memcpy'd struct format put on the wire for every snapshot:
+    // the header and a GameStatePayload with its original 32 enemies, 4
+    // players and 32 bullets, 1389 bytes. sizeof(GameStatePayload) has grown
+    // with the raised limits and would overstate the savings.
+    constexpr size_t rawHeaderSize = 10; // type, sequence, timestamp, flags
+    constexpr size_t rawEnemies = 32, rawPlayers = 4, rawBullets = 32;
+    constexpr size_t rawSize = rawHeaderSize + 3 +
+                               rawEnemies * sizeof(EnemyState) +
+                               rawPlayers * sizeof(GameStatePayload::PlayerState) +
+                               rawBullets * sizeof(BulletState);
+    static char fullPacket[maxReassembledSize];
+    static char deltaPacket[maxReassembledSize];
+    size_t rawBytes = 0, fullBytes = 0, sentBytes = 0, entities = 0, deltaEntities = 0;
+    size_t fullFallbacks = 0, fragmented = 0, lost = 0, mismatches = 0;
+    Clock::duration encodeFull{}, decodeFull{}, encodeDelta{}, decodeDelta{};
+    static char packedBody[maxReassembledSize * 2];
+    static char unpackedBody[maxReassembledSize];
+    size_t bodyBytes = 0, packedBytes = 0, packedNoDictBytes = 0, packets = 0;
+    size_t fullBodyBytes = 0, packedFullBytes = 0;
+    Clock::duration compressTime{}, decompressTime{};
+
+    for (size_t tick = 0; tick < frames.size(); tick++) {
+        while (!acksInFlight.empty() && acksInFlight.front().first <= tick) {
+            serverAcked = std::max(serverAcked, acksInFlight.front().second);
+            acksInFlight.pop_front();
+        }
+
+        uint32_t seq = static_cast<uint32_t>(tick + 1);
+        const GameStatePayload &current = frames[tick];
+        size_t count = current.numPlayers + current.numEnemies + current.numBullets;
+        serverHistory.store(seq, current);
+        rawBytes += rawSize;
+        entities += count;
+
+        const uint8_t fullType = static_cast<uint8_t>(MessageType::GAME_STATE);
+        const uint8_t deltaType = static_cast<uint8_t>(MessageType::GAME_STATE_DELTA);
+        auto t0 = Clock::now();
+        SnapshotTime time{seq, seq * static_cast<uint32_t>(1000 / serverTickRate)};
+        size_t fullLen = encodeGameStateBody(seq, time, current, fullPacket, sizeof(fullPacket));
+        auto t1 = Clock::now();
+        encodeFull += t1 - t0;
+        fullBytes += wireBytes(fullType, seq, fullPacket, fullLen);
+
+        GameStatePayload expected = current;
+        quantizeSnapshot(expected);
+        expected = canonical(expected);
+        {
+            auto d0 = Clock::now();
+            BitReader r(fullPacket, fullLen);
+            uint32_t rseq = 0;
+            GameStatePayload decoded;
+            SnapshotTime rtime;
+            bool ok = readSnapshotSequence(r, rseq) && rseq == seq && readSnapshotTime(r, rtime) &&
+                      rtime.tick == time.tick && decodeSnapshot(r, decoded);
+            decodeFull += Clock::now() - d0;
+            GameStatePayload got = canonical(decoded);
+            if (!ok || std::memcmp(&expected, &got, sizeof(GameStatePayload)) != 0)
+                mismatches++;
+        }
+
+        // Same choice broadcastGameState makes for each client.
+        const GameStatePayload* baseline = serverAcked ? serverHistory.find(serverAcked) : nullptr;
+        size_t deltaLen = 0;
+        if (baseline) {
+            auto e0 = Clock::now();
+            deltaLen = encodeGameStateDeltaBody(seq, serverAcked, time, *baseline, current,
+                                                deltaPacket, sizeof(deltaPacket));
+            encodeDelta += Clock::now() - e0;
+            deltaEntities += count;
+        }
+        bool useDelta = deltaLen && deltaLen < fullLen;
+        const char* sentPacket = useDelta ? deltaPacket : fullPacket;
+        size_t sentLen = useDelta ? deltaLen : fullLen;
+        sentBytes += wireBytes(useDelta ? deltaType : fullType, seq, sentPacket, sentLen);
+        if (sentLen > maxMessageBody)
+            fragmented++;
+        if (!useDelta)
+            fullFallbacks++;
+
+        // queueMessage() keeps the compressed body only when it is smaller.
+        {
+            const CompressionDictionary &dict = snapshotDictionary();
+            auto c0 = Clock::now();
+            size_t packedLen = compressBody(sentPacket, sentLen, packedBody, sizeof(packedBody), &dict);
+            auto c1 = Clock::now();
+            size_t unpackedLen = decompressBody(packedBody, packedLen, unpackedBody, sizeof(unpackedBody), &dict);
+            auto c2 = Clock::now();
+            compressTime += c1 - c0;
+            decompressTime += c2 - c1;
+            if (unpackedLen != sentLen || std::memcmp(unpackedBody, sentPacket, sentLen) != 0)
+                mismatches++;
+            size_t noDictLen = compressBody(sentPacket, sentLen, packedBody, sizeof(packedBody));
+            // What a client joining (or falling back to a full snapshot) would get.
+            size_t packedFullLen = compressBody(fullPacket, fullLen, packedBody, sizeof(packedBody), &dict);
+            fullBodyBytes += fullLen;
+            packedFullBytes += std::min(packedFullLen ? packedFullLen : fullLen, fullLen);
+            bodyBytes += sentLen;
+            packedBytes += std::min(packedLen ? packedLen : sentLen, sentLen);
+            packedNoDictBytes += std::min(noDictLen ? noDictLen : sentLen, sentLen);
+            packets++;
+        }
+
+        if (dropped(rng)) {
+            lost++;
+            continue;
+        }
+        GameStatePayload decoded;
+        if (useDelta) {
+            auto d0 = Clock::now();
+            BitReader r(deltaPacket, deltaLen);
+            uint32_t rseq = 0, baselineSeq = 0;
+            const GameStatePayload* clientBase = nullptr;
+            SnapshotTime rtime;
+            bool ok = readSnapshotSequence(r, rseq) && readDeltaBaseline(r, rseq, baselineSeq) &&
+                      readSnapshotTime(r, rtime) &&
+                      (clientBase = clientHistory.find(baselineSeq)) != nullptr &&
+                      decodeSnapshotDelta(r, *clientBase, decoded);
+            decodeDelta += Clock::now() - d0;
+            if (!ok) {
+                mismatches++;
+                continue;
+            }
+        } else {
+            decoded = expected;
+        }
+        GameStatePayload got = canonical(decoded);
+        if (std::memcmp(&expected, &got, sizeof(GameStatePayload)) != 0)
+            mismatches++;
+        clientHistory.store(seq, decoded);
+        if (!dropped(rng))
+            acksInFlight.emplace_back(tick + cfg.ackLag, seq);
+    }
+
+    auto nsPer = [](Clock::duration d, size_t n) {
+        return n ? static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / n : 0.0;
+    };
+    auto saved = [&](size_t bytes) { return 100.0 * (1.0 - static_cast<double>(bytes) / rawBytes); };
+    double n = static_cast<double>(frames.size());
+    std::cout << "[Bench] snapshots=" << frames.size() << " ack-lag=" << cfg.ackLag
+              << " loss=" << cfg.lossPercent << "% avg entities=" << std::fixed << std::setprecision(1)
+              << (entities / n) << "\n";
+    std::cout << "[Bench] raw structs  " << (rawBytes / n) << " bytes/snapshot\n"
+              << "[Bench] packed full  " << (fullBytes / n) << " bytes/snapshot (" << saved(fullBytes) << "% saved)\n"
+              << "[Bench] packed delta " << (sentBytes / n) << " bytes/snapshot (" << saved(sentBytes) << "% saved, "
+              << fullFallbacks << " full fallbacks, " << fragmented << " fragmented, " << lost << " lost)\n";
+    std::cout << "[Bench] full  encode " << nsPer(encodeFull, entities) << " ns/entity, decode "
+              << nsPer(decodeFull, entities) << " ns/entity\n"
+              << "[Bench] delta encode " << nsPer(encodeDelta, deltaEntities) << " ns/entity, decode "
+              << nsPer(decodeDelta, deltaEntities) << " ns/entity\n";
+    auto usPer = [&](Clock::duration d) { return nsPer(d, packets) / 1000.0; };
+    std::cout << std::setprecision(3)
+              << "[Bench] compressed   " << (static_cast<double>(packedBytes) / bodyBytes) << " of body bytes with dictionary, "
+              << (static_cast<double>(packedNoDictBytes) / bodyBytes) << " without ("
+              << (static_cast<double>(packedFullBytes) / fullBodyBytes) << " for full snapshots alone)\n"
+              << "[Bench] compression  encode " << usPer(compressTime) << " us/packet, decode "
+              << usPer(decompressTime) << " us/packet\n";
+    if (mismatches) {
+        std::cerr << "[Bench] " << mismatches << " snapshots decoded incorrectly.\n";
+        return 1;
+    }
+    return 0;
+}
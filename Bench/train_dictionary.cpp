@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Network/Protocol/Protocol.hpp"
+#include "Network/Protocol/SnapshotDelta.hpp"
+#include "Network/Protocol/Fragmentation.hpp"
+#include "Network/Protocol/Compression.hpp"
+#include "BenchArgs.hpp"
+
+// Trains the static dictionary compressBody() uses for snapshots.
+//
+// Replays matches recorded with `plugin_bench --record` through the
+// server's snapshot encoder, collecting every full and delta body a client
+// would be sent, then picks the segments of those bodies that cover the
+// most frequent byte patterns, in the spirit of zstd's COVER trainer.
+// The result is written as the byte list Network/Protocol/Compression.cpp
+// includes:
+//
+//   plugin_bench Game/libRTypeGamePlugin.so --scripted --ticks 4000 --record match.bin
+//   train_dictionary Network/Protocol/SnapshotDictionary.inc match.bin
+
+// Patterns are counted as k-byte substrings, and the dictionary is built
+// from segments of a few of them.
+constexpr size_t patternLen = 6;
+constexpr size_t segmentLen = 32;
+constexpr size_t segmentStep = 8;
+
+struct TrainConfig {
+    std::string outputPath;
+    std::vector<std::string> recordings;
+    size_t dictSize = 2048;
+    int ackLag = 2;
+
+    bool valid() const {
+        return ackLag >= 0 && dictSize >= segmentLen && dictSize <= CompressionDictionary::MaxSize;
+    }
+};
+
+// The bodies broadcastGameState would produce for a client acking every
+// snapshot `ackLag` ticks late: a full body every tick (what new clients
+// and fallbacks get) plus the delta against the acked baseline.
+static bool collectSamples(const std::string &path, int ackLag, std::vector<std::string> &samples) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    SnapshotRing history;
+    std::deque<uint32_t> pendingAcks;
+    uint32_t acked = 0;
+    static char body[maxReassembledSize];
+    GameStatePayload gs;
+    for (uint32_t seq = 1; in.read(reinterpret_cast<char*>(&gs), sizeof(GameStatePayload)); seq++) {
+        history.store(seq, gs);
+        SnapshotTime time{seq, seq * static_cast<uint32_t>(1000 / serverTickRate)};
+        size_t len = encodeGameStateBody(seq, time, gs, body, sizeof(body));
+        if (len)
+            samples.emplace_back(body, len);
+        if (const GameStatePayload* baseline = acked ? history.find(acked) : nullptr) {
+            len = encodeGameStateDeltaBody(seq, acked, time, *baseline, gs, body, sizeof(body));
+            if (len)
+                samples.emplace_back(body, len);
+        }
+        pendingAcks.push_back(seq);
+        if (pendingAcks.size() > static_cast<size_t>(ackLag)) {
+            acked = pendingAcks.front();
+            pendingAcks.pop_front();
+        }
+    }
+    return true;
+}
+
+static uint64_t patternAt(const std::string &s, size_t pos) {
+    uint64_t key = 0;
+    std::memcpy(&key, s.data() + pos, patternLen);
+    return key;
+}
+
+int main(int argc, char* argv[]) {
+    TrainConfig cfg;
+    BenchArgs args;
+    args.positional("output.inc", cfg.outputPath);
+    args.rest("recording", cfg.recordings);
+    args.option("--size", "BYTES", cfg.dictSize);
+    args.option("--ack-lag", "TICKS", cfg.ackLag);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> samples;
+    for (const std::string &path : cfg.recordings) {
+        if (!collectSamples(path, cfg.ackLag, samples)) {
+            std::cerr << "[Bench] Cannot read " << path << "\n";
+            return 1;
+        }
+    }
+    size_t sampleBytes = 0;
+    for (const std::string &s : samples)
+        sampleBytes += s.size();
+    if (sampleBytes == 0) {
+        std::cerr << "[Bench] No snapshots in the recordings.\n";
+        return 1;
+    }
+
+    // Frequency of a pattern is the number of samples it appears in, so a
+    // run repeated inside one body does not outweigh one shared by all.
+    std::unordered_map<uint64_t, uint32_t> frequency;
+    std::unordered_map<uint64_t, uint32_t> lastSample;
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        const std::string &s = samples[i];
+        for (size_t pos = 0; pos + patternLen <= s.size(); pos++) {
+            uint64_t key = patternAt(s, pos);
+            auto it = lastSample.find(key);
+            if (it != lastSample.end() && it->second == i + 1)
+                continue;
+            lastSample[key] = i + 1;
+            frequency[key]++;
+        }
+    }
+
+    struct Segment {
+        uint32_t sample;
+        uint32_t offset;
+    };
+    std::vector<Segment> segments;
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        for (size_t pos = 0; pos + segmentLen <= samples[i].size(); pos += segmentStep)
+            segments.push_back(Segment{i, static_cast<uint32_t>(pos)});
+    }
+    if (segments.empty()) {
+        std::cerr << "[Bench] Snapshot bodies are shorter than one segment.\n";
+        return 1;
+    }
+
+    // Greedy cover: take the segment whose not-yet-covered patterns are the
+    // most frequent, then zero those patterns so the next pick adds new ones.
+    std::vector<std::string> picked;
+    size_t dictBytes = 0;
+    while (dictBytes + segmentLen <= cfg.dictSize) {
+        uint64_t bestScore = 0;
+        size_t best = 0;
+        for (size_t i = 0; i < segments.size(); i++) {
+            const std::string &s = samples[segments[i].sample];
+            uint64_t score = 0;
+            for (size_t p = 0; p + patternLen <= segmentLen; p++) {
+                auto it = frequency.find(patternAt(s, segments[i].offset + p));
+                if (it != frequency.end())
+                    score += it->second;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                best = i;
+            }
+        }
+        if (bestScore == 0)
+            break;
+        const std::string &s = samples[segments[best].sample];
+        for (size_t p = 0; p + patternLen <= segmentLen; p++)
+            frequency.erase(patternAt(s, segments[best].offset + p));
+        picked.push_back(s.substr(segments[best].offset, segmentLen));
+        dictBytes += segmentLen;
+    }
+
+    // Best segments last, closest to the body.
+    std::string dict;
+    for (auto it = picked.rbegin(); it != picked.rend(); ++it)
+        dict += *it;
+
+    std::ofstream out(cfg.outputPath);
+    if (!out) {
+        std::cerr << "[Bench] Cannot open " << cfg.outputPath << " for writing.\n";
+        return 1;
+    }
+    out << "// Snapshot compression dictionary, " << dict.size() << " bytes, generated by\n"
+        << "// Bench/train_dictionary.cpp from " << samples.size() << " snapshot bodies. Do not edit.\n";
+    for (size_t i = 0; i < dict.size(); i++) {
+        out << static_cast<int>(static_cast<unsigned char>(dict[i])) << ",";
+        out << ((i % 16 == 15 || i + 1 == dict.size()) ? "\n" : " ");
+    }
+
+    // Quick check on the training set itself; snapshot_bench measures it
+    // properly on a separate recording.
+    CompressionDictionary trained(reinterpret_cast<const unsigned char*>(dict.data()), dict.size());
+    static char packed[maxReassembledSize * 2];
+    size_t plain = 0, withDict = 0;
+    for (const std::string &s : samples) {
+        size_t a = compressBody(s.data(), s.size(), packed, sizeof(packed));
+        size_t b = compressBody(s.data(), s.size(), packed, sizeof(packed), &trained);
+        plain += std::min(a ? a : s.size(), s.size());
+        withDict += std::min(b ? b : s.size(), s.size());
+    }
+    std::cout << "[Bench] samples=" << samples.size() << " avg body=" << (sampleBytes / samples.size())
+              << " bytes, dictionary=" << dict.size() << " bytes\n"
+              << "[Bench] training set: no dictionary " << (100.0 * plain / sampleBytes)
+              << "% of original, with dictionary " << (100.0 * withDict / sampleBytes) << "%\n";
+    return 0;
+}
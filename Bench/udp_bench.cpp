@@ -0,0 +1,270 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Network/Protocol/Protocol.hpp"
+#include "Network/Protocol/MessageCodec.hpp"
+#include "Network/Protocol/PacketBuilder.hpp"
+#include "Network/Protocol/DatagramRing.hpp"
+#include "Network/Server/UringSocket.hpp"
+#include "Network/Server/ReceiveShards.hpp"
+#include "BenchArgs.hpp"
+
+// Pushes datagrams through loopback for a fixed time with each way the
+// server can drive its socket (one sendto/recvfrom per datagram, the
+// sendmmsg/recvmmsg DatagramRing, io_uring) and reports packets/sec.
+// Then loads ReceiveShards from several client sockets at once with 1, 2,
+// ... up to --shards SO_REUSEPORT shards, each sending PLAYER_INPUT
+// datagrams the way a client does, counting the packets that reach the
+// consuming thread and the inputs that reach the input queue.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    double seconds = 2.0;
+    size_t size = 200;
+    size_t shards = 4;
+    size_t senders = 8;
+
+    bool valid() const {
+        return seconds > 0.0 && size > 0 && size <= maxPacketSize && shards > 0 && senders > 0;
+    }
+};
+
+struct BenchResult {
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t inputs = 0;
+    double seconds = 0.0;
+};
+
+static int openSocket(sockaddr_in &addr, bool reusePort = false) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+        return -1;
+    int one = 1;
+    if (reusePort)
+        setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    int bufSize = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+    // Lets the receiver notice the end of the run.
+    timeval timeout{0, 100000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&addr), len) < 0 ||
+        getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+enum class Mode { PerDatagram, Batched, IoUring };
+
+static BenchResult run(const BenchConfig &cfg, Mode mode) {
+    BenchResult result;
+    sockaddr_in rxAddr, txAddr;
+    int rx = openSocket(rxAddr);
+    int tx = openSocket(txAddr);
+    if (rx < 0 || tx < 0) {
+        std::cerr << "[Bench] Could not open loopback sockets.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    UringSocket txUring;
+    if (mode == Mode::IoUring && !txUring.open(tx)) {
+        close(rx);
+        close(tx);
+        return result;
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread receiver([&] {
+        if (mode == Mode::IoUring) {
+            UringSocket uring;
+            if (!uring.open(rx))
+                return;
+            while (!stop.load()) {
+                uring.poll(Clock::now() + std::chrono::milliseconds(100),
+                           [&](const sockaddr_in &, const char*, size_t) { result.received++; });
+            }
+        } else if (mode == Mode::Batched) {
+            DatagramRing ring;
+            while (true) {
+                int n = ring.receive(rx);
+                if (n > 0)
+                    result.received += static_cast<uint64_t>(n);
+                else if (stop.load())
+                    break;
+            }
+        } else {
+            char buffer[maxPacketSize];
+            while (true) {
+                sockaddr_in from;
+                socklen_t fromLen = sizeof(from);
+                if (recvfrom(rx, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &fromLen) > 0)
+                    result.received++;
+                else if (stop.load())
+                    break;
+            }
+        }
+    });
+
+    std::vector<char> payload(cfg.size, 'x');
+    DatagramRing ring;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cfg.seconds));
+    while (Clock::now() < deadline) {
+        // One "tick" worth of datagrams at a time, like the game loop.
+        for (size_t i = 0; i < ring.capacity(); i++) {
+            if (mode == Mode::IoUring) {
+                txUring.queue(rxAddr, payload.data(), payload.size());
+            } else if (mode == Mode::Batched) {
+                ring.queue(tx, rxAddr, payload.data(), payload.size());
+            } else if (sendto(tx, payload.data(), payload.size(), 0,
+                              reinterpret_cast<const sockaddr*>(&rxAddr), sizeof(rxAddr)) < 0) {
+                continue;
+            }
+            result.sent++;
+        }
+        if (mode == Mode::IoUring) {
+            // Reaps finished sends so their slots come back.
+            txUring.poll(Clock::now(), [](const sockaddr_in &, const char*, size_t) {});
+        } else if (mode == Mode::Batched) {
+            ring.flush(tx);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stop.store(true);
+    receiver.join();
+    close(rx);
+    close(tx);
+    return result;
+}
+
+// Every sender thread has its own socket, so its own source port for the
+// kernel to hash onto a shard.
+static BenchResult runSharded(const BenchConfig &cfg, size_t shardCount) {
+    BenchResult result;
+    sockaddr_in rxAddr;
+    int rx = openSocket(rxAddr, true);
+    ReceiveShards shards;
+    Engine::MpscQueue<PlayerInputPayload> inputs(ReceiveShards::QueueCapacity);
+    if (rx < 0 || !shards.start(rx, shardCount, inputs)) {
+        std::cerr << "[Bench] Could not open receive shards.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> senders;
+    std::atomic<uint64_t> sent{0};
+    for (size_t s = 0; s < cfg.senders; s++) {
+        senders.emplace_back([&, s] {
+            sockaddr_in txAddr;
+            int tx = openSocket(txAddr);
+            DatagramRing ring;
+            ReliableChannel channel;
+            PacketBuilder outgoing;
+            auto send = [&](const char* data, size_t len) { return ring.queue(tx, rxAddr, data, len); };
+            PlayerInputBatch batch{};
+            uint32_t tick = 0;
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t i = 0; i < ring.capacity(); i++) {
+                    batch.count = static_cast<uint8_t>(std::min<size_t>(batch.count + 1, inputRedundancy));
+                    for (size_t j = batch.count - 1; j > 0; j--)
+                        batch.inputs[j] = batch.inputs[j - 1];
+                    batch.inputs[0] = PlayerInputPayload{static_cast<int32_t>(s + 1), ++tick, false, false, false,
+                                                         (tick / 8) % 2 == 0, false};
+                    char body[maxMessageBody];
+                    size_t len = 0;
+                    encodeMessageBody(static_cast<uint8_t>(MessageType::PLAYER_INPUT), &batch, sizeof(batch),
+                                      body, sizeof(body), len);
+                    MessageHeader h{static_cast<uint8_t>(MessageType::PLAYER_INPUT), 0, 0};
+                    outgoing.add(channel, h, body, len, send);
+                    outgoing.flush(channel, send);
+                }
+                ring.flush(tx);
+                count += ring.capacity();
+            }
+            sent += count;
+            close(tx);
+        });
+    }
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cfg.seconds));
+    ReceivedPacket packet;
+    PlayerInputPayload input;
+    while (shards.wait(deadline)) {
+        while (shards.pop(packet))
+            result.received++;
+        while (inputs.tryPop(input))
+            result.inputs++;
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stop.store(true);
+    for (auto &t : senders)
+        t.join();
+    shards.stop();
+    close(rx);
+    result.sent = sent.load();
+    return result;
+}
+
+static void report(const char* name, const BenchResult &r) {
+    if (r.seconds == 0.0) {
+        std::cout << std::left << std::setw(20) << name << "unavailable\n";
+        return;
+    }
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::setw(12) << static_cast<uint64_t>(r.sent / r.seconds) << " sent/s"
+              << std::setw(12) << static_cast<uint64_t>(r.received / r.seconds) << " received/s"
+              << std::setw(8) << std::fixed << std::setprecision(1)
+              << (r.sent ? 100.0 * (r.sent - r.received) / r.sent : 0.0) << "% dropped";
+    if (r.inputs)
+        std::cout << std::setw(12) << static_cast<uint64_t>(r.inputs / r.seconds) << " inputs/s";
+    std::cout << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    BenchArgs args;
+    args.option("--seconds", "S", cfg.seconds);
+    args.option("--size", "BYTES", cfg.size);
+    args.option("--shards", "N", cfg.shards);
+    args.option("--senders", "N", cfg.senders);
+    if (!args.parse(argc, argv) || !cfg.valid()) {
+        args.printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::cout << "[Bench] " << cfg.size << "-byte datagrams over loopback, "
+              << cfg.seconds << " s per mode, batches of " << DatagramRing::DefaultSlots << "\n";
+    report("sendto/recvfrom", run(cfg, Mode::PerDatagram));
+    report("sendmmsg/recvmmsg", run(cfg, Mode::Batched));
+    report("io_uring", run(cfg, Mode::IoUring));
+
+    std::cout << "[Bench] SO_REUSEPORT shards, " << cfg.senders << " sending sockets\n";
+    for (size_t n = 1; n <= cfg.shards; n *= 2) {
+        std::string name = std::to_string(n) + " shard" + (n > 1 ? "s" : "");
+        report(name.c_str(), runSharded(cfg, n));
+    }
+    return EXIT_SUCCESS;
+}
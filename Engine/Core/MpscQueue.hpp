@@ -0,0 +1,93 @@
+#ifndef ENGINE_MPSCQUEUE_HPP
+#define ENGINE_MPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Engine {
+
+    // Bounded lock-free multi-producer / single-consumer queue.
+    // Each cell carries a sequence number telling producers and the consumer
+    // whose turn it is, so neither side ever waits on a lock. Pushing into a
+    // full queue fails instead of blocking.
+    template<typename T>
+    class MpscQueue {
+    public:
+        explicit MpscQueue(size_t capacity) {
+            size_t cap = 2;
+            while (cap < capacity)
+                cap <<= 1;
+            m_mask = cap - 1;
+            m_cells.reset(new Cell[cap]);
+            for (size_t i = 0; i < cap; ++i)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        // Safe to call from any number of threads.
+        bool tryPush(const T& value) {
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &m_cells[pos & m_mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = value;
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side only.
+        bool tryPop(T& out) {
+            size_t pos = m_head.load(std::memory_order_relaxed);
+            Cell& cell = m_cells[pos & m_mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq != pos + 1)
+                return false;
+            out = cell.value;
+            cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+            m_head.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Consumer side only. Appends everything currently queued to `out`.
+        size_t drain(std::vector<T>& out) {
+            size_t count = 0;
+            T value;
+            while (tryPop(value)) {
+                out.push_back(value);
+                ++count;
+            }
+            return count;
+        }
+
+        size_t capacity() const { return m_mask + 1; }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        size_t m_mask = 0;
+        alignas(64) std::atomic<size_t> m_tail{0};
+        alignas(64) std::atomic<size_t> m_head{0};
+    };
+
+}
+
+#endif // ENGINE_MPSCQUEUE_HPP
@@ -0,0 +1,49 @@
+#ifndef ENGINE_TRIPLEBUFFER_HPP
+#define ENGINE_TRIPLEBUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace Engine {
+
+    // Lock-free single-producer / single-consumer hand-off of the latest
+    // value. The producer fills back() and publish()es it; the consumer
+    // calls consume() and reads front(). A third buffer sits between them,
+    // so neither side ever waits for the other or sees a half-written value.
+    // Values the consumer never got to are simply replaced.
+    template<typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // Producer side only.
+        T& back() { return m_buffers[m_back]; }
+        void publish() {
+            m_back = m_middle.exchange(static_cast<uint8_t>(m_back | Fresh), std::memory_order_acq_rel) & IndexMask;
+        }
+
+        // Consumer side only. True if a value newer than front() was
+        // published; front() then returns it.
+        bool consume() {
+            if (!(m_middle.load(std::memory_order_relaxed) & Fresh))
+                return false;
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+            return true;
+        }
+        const T& front() const { return m_buffers[m_front]; }
+
+    private:
+        static constexpr uint8_t IndexMask = 3;
+        static constexpr uint8_t Fresh = 4;
+
+        T m_buffers[3]{};
+        uint8_t m_back = 0;
+        std::atomic<uint8_t> m_middle{1};
+        uint8_t m_front = 2;
+    };
+
+}
+
+#endif // ENGINE_TRIPLEBUFFER_HPP
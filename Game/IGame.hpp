@@ -2,18 +2,56 @@
 #define IGAME_HPP
 
 #include "Network/Protocol/Protocol.hpp"
+#include <cstddef>
 
 struct GameState {
     GameStatePayload payload{};
 };
 
+enum class EntityKind : uint8_t {
+    Player,
+    Enemy,
+    Bullet
+};
+
+// The part of the world a client needs, around its player.
+struct InterestArea {
+    float x = 0.f;
+    float y = 0.f;
+    float radius = 0.f;
+};
+
 class IGame {
 public:
     virtual ~IGame() = default;
     virtual void onStart() = 0;
     virtual void onPlayerInput(const PlayerInputPayload& input) = 0;
+    // Called once per tick with every input received since the previous tick.
+    virtual void onPlayerInputs(const PlayerInputPayload* inputs, size_t count) {
+        for (size_t i = 0; i < count; i++)
+            onPlayerInput(inputs[i]);
+    }
     virtual void onUpdate(float dt) = 0;
     virtual GameState getGameState() = 0;
+
+    // Interest management. Called by the network send stage while the next
+    // tick runs, so implementations must only look at their arguments.
+    //
+    // Where the client playing `viewerID` is looking in `snapshot`. Returning
+    // false, the default, sends that client the whole snapshot.
+    virtual bool getInterestArea(const GameStatePayload& snapshot, int32_t viewerID,
+                                 InterestArea& area) const {
+        (void)snapshot; (void)viewerID; (void)area;
+        return false;
+    }
+    // Final say on an entity inside the viewer's area, `index` being its
+    // position in the snapshot list of its kind. Players and the viewer's
+    // own bullets are always sent and never asked about.
+    virtual bool isRelevant(const GameStatePayload& snapshot, int32_t viewerID,
+                            EntityKind kind, size_t index) const {
+        (void)snapshot; (void)viewerID; (void)kind; (void)index;
+        return true;
+    }
 };
 
 extern "C" {
@@ -1,4 +1,5 @@
 #include "RTypeGamePlugin.hpp"
+#include "RTypeMovement.hpp"
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
@@ -8,6 +9,7 @@ RTypeGamePlugin::RTypeGamePlugin()
     : waveTimer(0.0f), waveIndex(0),
       spawnInterval(8.0f), spawnCount(5),
       baseEnemySpeed(-50.0f), baseEnemyShootTime(2.0f), bulletSpeed(200.f),
+      viewRadius(1000.f),
       nextEnemyID(1), nextBulletID(1000)
 {
 }
@@ -33,12 +35,13 @@ void RTypeGamePlugin::onPlayerInput(const PlayerInputPayload& input) {
         p.health = 3;
         players[input.netID] = p;
     }
+    // Clients only send when their input changes, so movement is held state
+    // applied in onUpdate rather than a step per packet.
     Player& p = players[input.netID];
-    constexpr float moveSpeed = 150.0f * 0.09f;
-    if (input.up) p.y -= moveSpeed;
-    if (input.down) p.y += moveSpeed;
-    if (input.left) p.x -= moveSpeed;
-    if (input.right) p.x += moveSpeed;
+    p.up = input.up;
+    p.down = input.down;
+    p.left = input.left;
+    p.right = input.right;
     if (input.shoot) {
         Bullet b;
         b.bulletID = nextBulletID++;
@@ -53,6 +56,10 @@ void RTypeGamePlugin::onPlayerInput(const PlayerInputPayload& input) {
 }
 
 void RTypeGamePlugin::onUpdate(float dt) {
+    for (auto& kv : players) {
+        Player& p = kv.second;
+        RTypeMovement::movePlayer(p.x, p.y, p.up, p.down, p.left, p.right, dt);
+    }
     waveTimer += dt;
     if (waveTimer >= spawnInterval) {
         waveTimer = 0.f;
@@ -150,7 +157,7 @@ GameState RTypeGamePlugin::getGameState() {
     std::memset(&state.payload, 0, sizeof(GameStatePayload));
     int pCount = 0;
     for (const auto& kv : players) {
-        if (pCount >= 4) break;
+        if (pCount >= static_cast<int>(maxSnapshotPlayers)) break;
         const Player& p = kv.second;
         state.payload.players[pCount].playerID = p.id;
         state.payload.players[pCount].x = p.x;
@@ -162,7 +169,7 @@ GameState RTypeGamePlugin::getGameState() {
     int eCount = 0;
     for (const auto& enemy : enemies) {
         if (!enemy.active) continue;
-        if (eCount >= 32) break;
+        if (eCount >= static_cast<int>(maxSnapshotEnemies)) break;
         state.payload.enemies[eCount].enemyID = enemy.enemyID;
         state.payload.enemies[eCount].x = enemy.x;
         state.payload.enemies[eCount].y = enemy.y;
@@ -174,7 +181,7 @@ GameState RTypeGamePlugin::getGameState() {
     int bCount = 0;
     for (const auto& b : bullets) {
         if (!b.active) continue;
-        if (bCount >= 32) break;
+        if (bCount >= static_cast<int>(maxSnapshotBullets)) break;
         state.payload.bullets[bCount].bulletID = b.bulletID;
         state.payload.bullets[bCount].x = b.x;
         state.payload.bullets[bCount].y = b.y;
@@ -187,6 +194,21 @@ GameState RTypeGamePlugin::getGameState() {
     return state;
 }
 
+// Centered on the viewer's ship. The radius reaches every corner of the
+// 800x600 screen from anywhere on it, so today every client still sees the
+// whole level; it only starts culling in worlds larger than one screen.
+bool RTypeGamePlugin::getInterestArea(const GameStatePayload& snapshot, int32_t viewerID,
+                                      InterestArea& area) const {
+    for (size_t i = 0; i < snapshot.numPlayers; i++) {
+        if (snapshot.players[i].playerID != viewerID) continue;
+        area.x = snapshot.players[i].x;
+        area.y = snapshot.players[i].y;
+        area.radius = viewRadius;
+        return true;
+    }
+    return false;
+}
+
 void RTypeGamePlugin::spawnWave() {
     Enemy boss;
     boss.enemyID = nextEnemyID++;
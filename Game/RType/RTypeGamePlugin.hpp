@@ -14,6 +14,8 @@ public:
     void onPlayerInput(const PlayerInputPayload& input) override;
     void onUpdate(float dt) override;
     GameState getGameState() override;
+    bool getInterestArea(const GameStatePayload& snapshot, int32_t viewerID,
+                         InterestArea& area) const override;
 private:
     void spawnWave();
     bool checkCollision(float x1, float y1, float x2, float y2, float radius = 20.f) const;
@@ -27,6 +29,7 @@ private:
     const float baseEnemySpeed;
     const float baseEnemyShootTime;
     const float bulletSpeed;
+    const float viewRadius;
     int32_t nextEnemyID;
     int32_t nextBulletID;
 };
@@ -0,0 +1,20 @@
+#ifndef RTYPE_MOVEMENT_HPP
+#define RTYPE_MOVEMENT_HPP
+
+// How a player ship moves under the directions it holds. Shared by the
+// server plugin and the client's prediction of its own ship, which must
+// agree for predicted positions to match the snapshots.
+namespace RTypeMovement {
+
+constexpr float playerMoveSpeed = 200.0f;
+
+inline void movePlayer(float &x, float &y, bool up, bool down, bool left, bool right, float dt) {
+    if (up) y -= playerMoveSpeed * dt;
+    if (down) y += playerMoveSpeed * dt;
+    if (left) x -= playerMoveSpeed * dt;
+    if (right) x += playerMoveSpeed * dt;
+}
+
+} // namespace RTypeMovement
+
+#endif // RTYPE_MOVEMENT_HPP
@@ -15,6 +15,11 @@ struct Player {
     float x;
     float y;
     int32_t health;
+    // Directions held in the player's latest input; applied every update.
+    bool up = false;
+    bool down = false;
+    bool left = false;
+    bool right = false;
 };
 
 struct Enemy {
@@ -3,6 +3,7 @@
 #include <ctime>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
 
 SnakeGamePlugin::SnakeGamePlugin()
     : moveAccumulator(0.f),
@@ -88,7 +89,7 @@ GameState SnakeGamePlugin::getGameState() {
     std::memset(&state.payload, 0, sizeof(GameStatePayload));
     int playerCount = 0;
     for (const auto &pair : snakes) {
-        if (playerCount >= 4) break;
+        if (playerCount >= static_cast<int>(maxSnapshotPlayers)) break;
         const Snake &snake = pair.second;
         state.payload.players[playerCount].playerID = snake.netID;
         state.payload.players[playerCount].x = snake.body.front().x * cellSize;
@@ -99,7 +100,7 @@ GameState SnakeGamePlugin::getGameState() {
     state.payload.numPlayers = static_cast<uint8_t>(playerCount);
     int foodCount = 0;
     for (const auto &f : foods) {
-        if (foodCount >= 32) break;
+        if (foodCount >= static_cast<int>(maxSnapshotEnemies)) break;
         state.payload.enemies[foodCount].enemyID = f.id;
         state.payload.enemies[foodCount].x = f.pos.x * cellSize;
         state.payload.enemies[foodCount].y = f.pos.y * cellSize;
@@ -111,7 +112,7 @@ GameState SnakeGamePlugin::getGameState() {
     for (const auto &pair : snakes) {
         const Snake &snake = pair.second;
         for (size_t i = 1; i < snake.body.size(); ++i) {
-            if (segmentCount >= 32) break;
+            if (segmentCount >= static_cast<int>(maxSnapshotBullets)) break;
             state.payload.bullets[segmentCount].bulletID = snake.netID * 1000 + static_cast<int>(i);
             state.payload.bullets[segmentCount].x = snake.body[i].x * cellSize;
             state.payload.bullets[segmentCount].y = snake.body[i].y * cellSize;
@@ -125,6 +126,21 @@ GameState SnakeGamePlugin::getGameState() {
     return state;
 }
 
+// Around the viewer's head, wide enough to span the grid: segments of one
+// snake are separate entities, and a snake cut in half at the edge of the
+// area would look wrong.
+bool SnakeGamePlugin::getInterestArea(const GameStatePayload& snapshot, int32_t viewerID,
+                                      InterestArea& area) const {
+    for (size_t i = 0; i < snapshot.numPlayers; i++) {
+        if (snapshot.players[i].playerID != viewerID) continue;
+        area.x = snapshot.players[i].x;
+        area.y = snapshot.players[i].y;
+        area.radius = std::hypot(static_cast<float>(gridWidth), static_cast<float>(gridHeight)) * cellSize;
+        return true;
+    }
+    return false;
+}
+
 void SnakeGamePlugin::updateSnake(Snake &snake) {
     GridPosition head = snake.body.front();
     GridPosition newHead = head;
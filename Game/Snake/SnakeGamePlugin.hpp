@@ -15,6 +15,8 @@ public:
     void onPlayerInput(const PlayerInputPayload& input) override;
     void onUpdate(float dt) override;
     GameState getGameState() override;
+    bool getInterestArea(const GameStatePayload& snapshot, int32_t viewerID,
+                         InterestArea& area) const override;
 
 private:
     void updateSnake(Snake &snake);
@@ -10,7 +10,9 @@
 #include "Game/Components/Components.hpp"
 #include "Game/Systems/Systems.hpp"
 #include "Network/System/NetworkSystem.hpp"
+#include "Network/System/InputSampler.hpp"
 #include "Network/Protocol/Protocol.hpp"
+#include "Game/RType/RTypeMovement.hpp"
 
 static std::string GetAssetPath(const std::string &assetName) {
     return (std::filesystem::current_path() / "assets" / assetName).string();
@@ -21,19 +23,18 @@ enum class GameScene {
     GAME
 };
 
+// Never touches the ECS: snapshots are handed to the main thread, which
+// applies them in networkSystem.update() at the start of each frame.
+// pump() blocks until datagrams arrive or a timer is due.
 void networkThreadFunc(NetworkSystem &netSys,
-                       Engine::EntityManager &em,
-                       Engine::ComponentManager &cm,
                        std::atomic<bool> &stopFlag,
                        std::atomic<bool> &gameStartedFlag)
 {
-    constexpr auto frameDuration = std::chrono::milliseconds(16);
     while (!stopFlag.load()) {
-        netSys.update(0.016f, em, cm);
+        netSys.pump();
         if (netSys.isGameStarted()) {
             gameStartedFlag.store(true);
         }
-        std::this_thread::sleep_for(frameDuration);
     }
 }
 
@@ -86,7 +87,7 @@ int main(int argc, char* argv[]) {
     RenderSystem renderSystem;
     InputSystem inputSystem;
     AudioSystem audioSystem(beepSound);
-    NetworkSystem networkSystem(serverIP, serverPort, clientPort);
+    NetworkSystem networkSystem(serverIP, serverPort, clientPort, RTypeMovement::movePlayer);
 
     componentManager.setGlobalTexture("player", playerTexture);
     componentManager.setGlobalTexture("remotePlayer", remotePlayerTexture);
@@ -98,13 +99,12 @@ int main(int argc, char* argv[]) {
     std::atomic<bool> hasGameStarted{false};
     std::thread netThread(networkThreadFunc,
                           std::ref(networkSystem),
-                          std::ref(entityManager),
-                          std::ref(componentManager),
                           std::ref(stopNetThread),
                           std::ref(hasGameStarted));
 
     GameScene scene = GameScene::MENU;
     bool sentReady = false;
+    InputSampler inputSampler;
     while (!Engine::Window::ShouldCloseWindow()) {
         float dt = GetFrameTime();
         if (scene == GameScene::MENU) {
@@ -125,6 +125,7 @@ int main(int argc, char* argv[]) {
             }
         }
         else if (scene == GameScene::GAME) {
+            networkSystem.update(dt, entityManager, componentManager);
             if (auto health = componentManager.getComponent<Health>(localPlayer)) {
                 if (health->current > 0) {
                     inputSystem.handleInput(entityManager, componentManager);
@@ -138,7 +139,9 @@ int main(int argc, char* argv[]) {
             inputPayload.left  = IsKeyDown(KEY_LEFT);
             inputPayload.right = IsKeyDown(KEY_RIGHT);
             inputPayload.shoot = IsKeyPressed(KEY_SPACE);
-            networkSystem.sendPacket(static_cast<uint8_t>(MessageType::PLAYER_INPUT), &inputPayload, sizeof(inputPayload), false);
+            PlayerInputPayload sample;
+            if (inputSampler.update(dt, inputPayload, sample))
+                networkSystem.sendInput(sample);
             audioSystem.update(dt, entityManager, componentManager);
             Engine::Window::StartDrawing();
             Engine::Window::ClearScreen(RAYWHITE);
@@ -157,6 +160,7 @@ int main(int argc, char* argv[]) {
                     std::cout << "Local player is dead. Returning to lobby...\n";
                     scene = GameScene::MENU;
                     sentReady = false;
+                    inputSampler.reset();
                     entityManager.destroyEntity(localPlayer);
                     localPlayer = entityManager.createEntity();
                     componentManager.addComponent(localPlayer, Position{100.f, 300.f});
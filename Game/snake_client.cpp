@@ -12,6 +12,7 @@
 #include "Game/Components/Components.hpp"
 #include "Game/Systems/Systems.hpp"
 #include "Network/System/NetworkSystem.hpp"
+#include "Network/System/InputSampler.hpp"
 #include "Network/Protocol/Protocol.hpp"
 
 static std::string GetAssetPath(const std::string &assetName) {
@@ -23,19 +24,18 @@ enum class GameScene {
     GAME
 };
 
+// Never touches the ECS: snapshots are handed to the main thread, which
+// applies them in networkSystem.update() at the start of each frame.
+// pump() blocks until datagrams arrive or a timer is due.
 void networkThreadFunc(NetworkSystem &netSys,
-                       Engine::EntityManager &em,
-                       Engine::ComponentManager &cm,
                        std::atomic<bool> &stopFlag,
                        std::atomic<bool> &gameStartedFlag)
 {
-    constexpr auto frameDuration = std::chrono::milliseconds(16);
     while (!stopFlag.load()) {
-        netSys.update(0.016f, em, cm);
+        netSys.pump();
         if (netSys.isGameStarted()) {
             gameStartedFlag.store(true);
         }
-        std::this_thread::sleep_for(frameDuration);
     }
 }
 
@@ -96,13 +96,12 @@ int main(int argc, char* argv[]) {
     std::atomic<bool> hasGameStarted{false};
     std::thread netThread(networkThreadFunc,
                           std::ref(networkSystem),
-                          std::ref(entityManager),
-                          std::ref(componentManager),
                           std::ref(stopNetThread),
                           std::ref(hasGameStarted));
 
     GameScene scene = GameScene::MENU;
     bool sentReady = false;
+    InputSampler inputSampler;
     while (!Engine::Window::ShouldCloseWindow()) {
         float dt = GetFrameTime();
 
@@ -125,6 +124,7 @@ int main(int argc, char* argv[]) {
             }
         }
         else if (scene == GameScene::GAME) {
+            networkSystem.update(dt, entityManager, componentManager);
             if (auto health = componentManager.getComponent<Health>(localPlayer)) {
                 if (health->current > 1) {
                     inputSystem.handleInput(entityManager, componentManager);
@@ -138,7 +138,9 @@ int main(int argc, char* argv[]) {
             inputPayload.left  = IsKeyDown(KEY_LEFT);
             inputPayload.right = IsKeyDown(KEY_RIGHT);
             inputPayload.shoot = false;
-            networkSystem.sendPacket(static_cast<uint8_t>(MessageType::PLAYER_INPUT), &inputPayload, sizeof(inputPayload), false);
+            PlayerInputPayload sample;
+            if (inputSampler.update(dt, inputPayload, sample))
+                networkSystem.sendInput(sample);
 
             audioSystem.update(dt, entityManager, componentManager);
 
@@ -160,6 +162,7 @@ int main(int argc, char* argv[]) {
                     std::cout << "Local player is dead. Returning to lobby...\n";
                     scene = GameScene::MENU;
                     sentReady = false;
+                    inputSampler.reset();
                     entityManager.destroyEntity(localPlayer);
                     localPlayer = entityManager.createEntity();
                     componentManager.addComponent(localPlayer, Position{100.f, 300.f});
@@ -0,0 +1,170 @@
+#ifndef BITSTREAM_HPP
+#define BITSTREAM_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Bit-level writer/reader used for everything that goes on the wire.
+// Bits are packed LSB-first into bytes; multi-byte values are little-endian.
+
+// Range [min, max) mapped onto `bits` bits. Ranges are chosen so the step is
+// a power of two, which makes dequantize(quantize(v)) exact and repeatable.
+struct QuantRange {
+    float min;
+    float max;
+    unsigned bits;
+};
+
+// Covers the 800x600 field plus the off-screen margins where enemies spawn
+// and bullets despawn, at 1/32 px resolution.
+constexpr QuantRange positionRange{-512.f, 1536.f, 16};
+constexpr QuantRange velocityRange{-1024.f, 1024.f, 16};
+
+inline uint32_t quantize(float value, const QuantRange &range) {
+    const uint32_t maxQ = (1u << range.bits) - 1;
+    const float step = (range.max - range.min) / static_cast<float>(1u << range.bits);
+    if (!(value > range.min))
+        return 0;
+    float q = std::round((value - range.min) / step);
+    if (q >= static_cast<float>(maxQ))
+        return maxQ;
+    return static_cast<uint32_t>(q);
+}
+
+inline float dequantize(uint32_t q, const QuantRange &range) {
+    const float step = (range.max - range.min) / static_cast<float>(1u << range.bits);
+    return range.min + static_cast<float>(q) * step;
+}
+
+class BitWriter {
+public:
+    BitWriter(char* out, size_t capacity) : m_out(reinterpret_cast<uint8_t*>(out)), m_capacity(capacity) {}
+
+    void writeBits(uint32_t value, unsigned bits) {
+        if (bits < 32)
+            value &= (1u << bits) - 1;
+        m_scratch |= static_cast<uint64_t>(value) << m_scratchBits;
+        m_scratchBits += bits;
+        while (m_scratchBits >= 8) {
+            putByte(static_cast<uint8_t>(m_scratch));
+            m_scratch >>= 8;
+            m_scratchBits -= 8;
+        }
+    }
+
+    void writeBool(bool value) { writeBits(value ? 1u : 0u, 1); }
+
+    // 7 bits per group, high bit set while more groups follow.
+    void writeVarUint(uint32_t value) {
+        while (value >= 0x80) {
+            writeBits((value & 0x7F) | 0x80, 8);
+            value >>= 7;
+        }
+        writeBits(value, 8);
+    }
+
+    void writeVarInt(int32_t value) {
+        uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        writeVarUint(zigzag);
+    }
+
+    void writeQuantized(float value, const QuantRange &range) { writeBits(quantize(value, range), range.bits); }
+
+    // Pads the last partial byte and returns the number of bytes written,
+    // or 0 if the buffer was too small.
+    size_t finish() {
+        if (m_scratchBits > 0) {
+            putByte(static_cast<uint8_t>(m_scratch));
+            m_scratch = 0;
+            m_scratchBits = 0;
+        }
+        return m_overflow ? 0 : m_pos;
+    }
+
+    size_t bitsWritten() const { return m_pos * 8 + m_scratchBits; }
+    bool ok() const { return !m_overflow; }
+
+private:
+    void putByte(uint8_t byte) {
+        if (m_pos >= m_capacity) {
+            m_overflow = true;
+            return;
+        }
+        m_out[m_pos++] = byte;
+    }
+
+    uint8_t* m_out;
+    size_t m_capacity;
+    size_t m_pos = 0;
+    uint64_t m_scratch = 0;
+    unsigned m_scratchBits = 0;
+    bool m_overflow = false;
+};
+
+class BitReader {
+public:
+    BitReader(const char* data, size_t len) : m_data(reinterpret_cast<const uint8_t*>(data)), m_len(len) {}
+
+    bool readBits(uint32_t &value, unsigned bits) {
+        while (m_scratchBits < bits) {
+            if (m_pos >= m_len)
+                return false;
+            m_scratch |= static_cast<uint64_t>(m_data[m_pos++]) << m_scratchBits;
+            m_scratchBits += 8;
+        }
+        value = static_cast<uint32_t>(bits < 32 ? (m_scratch & ((1ull << bits) - 1)) : m_scratch);
+        m_scratch >>= bits;
+        m_scratchBits -= bits;
+        return true;
+    }
+
+    bool readBool(bool &value) {
+        uint32_t bit;
+        if (!readBits(bit, 1))
+            return false;
+        value = (bit != 0);
+        return true;
+    }
+
+    bool readVarUint(uint32_t &value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 35; shift += 7) {
+            uint32_t group;
+            if (!readBits(group, 8))
+                return false;
+            value |= (group & 0x7F) << shift;
+            if (!(group & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readVarInt(int32_t &value) {
+        uint32_t zigzag;
+        if (!readVarUint(zigzag))
+            return false;
+        value = static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        return true;
+    }
+
+    bool readQuantized(float &value, const QuantRange &range) {
+        uint32_t q;
+        if (!readBits(q, range.bits))
+            return false;
+        value = dequantize(q, range);
+        return true;
+    }
+
+    // Bytes consumed so far, counting a partially read byte as consumed.
+    size_t bytesRead() const { return m_pos; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_len;
+    size_t m_pos = 0;
+    uint64_t m_scratch = 0;
+    unsigned m_scratchBits = 0;
+};
+
+#endif // BITSTREAM_HPP
@@ -0,0 +1,190 @@
+#include "Compression.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+constexpr size_t MinMatch = 4;
+constexpr size_t MaxOffset = 65535;
+constexpr unsigned HashBits = CompressionDictionary::HashBits;
+
+inline uint32_t hash4(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - HashBits);
+}
+
+// Positions are counted across the dictionary followed by the body, so a
+// match offset may point back into the dictionary.
+class Window {
+public:
+    Window(const CompressionDictionary* dict, const unsigned char* body)
+        : m_dict(dict ? dict->data() : nullptr), m_dictSize(dict ? dict->size() : 0), m_body(body) {}
+
+    size_t dictSize() const { return m_dictSize; }
+    unsigned char at(size_t pos) const { return pos < m_dictSize ? m_dict[pos] : m_body[pos - m_dictSize]; }
+
+private:
+    const unsigned char* m_dict;
+    size_t m_dictSize;
+    const unsigned char* m_body;
+};
+
+class Output {
+public:
+    Output(char* out, size_t capacity) : m_out(reinterpret_cast<unsigned char*>(out)), m_capacity(capacity) {}
+
+    void put(unsigned char byte) {
+        if (m_pos >= m_capacity) {
+            m_overflow = true;
+            return;
+        }
+        m_out[m_pos++] = byte;
+    }
+    void put(const unsigned char* bytes, size_t len) {
+        if (len > m_capacity - std::min(m_pos, m_capacity)) {
+            m_overflow = true;
+            return;
+        }
+        std::memcpy(m_out + m_pos, bytes, len);
+        m_pos += len;
+    }
+    // What a nibble of 15 leaves over, in bytes of up to 255.
+    void putLength(size_t rest) {
+        while (rest >= 255) {
+            put(255);
+            rest -= 255;
+        }
+        put(static_cast<unsigned char>(rest));
+    }
+    size_t finish() const { return m_overflow ? 0 : m_pos; }
+
+private:
+    unsigned char* m_out;
+    size_t m_capacity;
+    size_t m_pos = 0;
+    bool m_overflow = false;
+};
+
+void writeSequence(Output &out, const unsigned char* literals, size_t literalLen, size_t offset, size_t matchLen) {
+    size_t litNibble = std::min<size_t>(literalLen, 15);
+    size_t matchNibble = matchLen ? std::min<size_t>(matchLen - MinMatch, 15) : 0;
+    out.put(static_cast<unsigned char>((litNibble << 4) | matchNibble));
+    if (litNibble == 15)
+        out.putLength(literalLen - 15);
+    out.put(literals, literalLen);
+    if (matchLen == 0)
+        return;
+    out.put(static_cast<unsigned char>(offset & 0xFF));
+    out.put(static_cast<unsigned char>(offset >> 8));
+    if (matchNibble == 15)
+        out.putLength(matchLen - MinMatch - 15);
+}
+
+bool readLength(const unsigned char* in, size_t len, size_t &pos, size_t &value) {
+    unsigned char byte;
+    do {
+        if (pos >= len)
+            return false;
+        byte = in[pos++];
+        value += byte;
+    } while (byte == 255);
+    return true;
+}
+
+const unsigned char trainedSnapshotDictionary[] = {
+#include "SnapshotDictionary.inc"
+};
+
+} // namespace
+
+CompressionDictionary::CompressionDictionary(const unsigned char* data, size_t size)
+    : m_data(data), m_size(std::min(size, MaxSize)) {
+    std::fill(std::begin(m_table), std::end(m_table), -1);
+    for (size_t i = 0; i + MinMatch <= m_size; i++)
+        m_table[hash4(m_data + i)] = static_cast<int32_t>(i);
+}
+
+const CompressionDictionary &snapshotDictionary() {
+    static const CompressionDictionary dict(trainedSnapshotDictionary, sizeof(trainedSnapshotDictionary));
+    return dict;
+}
+
+size_t compressBody(const char* in, size_t len, char* out, size_t capacity, const CompressionDictionary* dict) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    Window window(dict, src);
+    const size_t base = window.dictSize();
+
+    int32_t table[1u << HashBits];
+    if (dict)
+        std::memcpy(table, dict->table(), sizeof(table));
+    else
+        std::fill(std::begin(table), std::end(table), -1);
+
+    Output o(out, capacity);
+    size_t anchor = 0;
+    size_t ip = 0;
+    while (ip + MinMatch <= len) {
+        uint32_t h = hash4(src + ip);
+        int32_t candidate = table[h];
+        size_t here = base + ip;
+        table[h] = static_cast<int32_t>(here);
+        if (candidate < 0 || here - static_cast<size_t>(candidate) > MaxOffset) {
+            ip++;
+            continue;
+        }
+        size_t from = static_cast<size_t>(candidate);
+        size_t matchLen = 0;
+        while (ip + matchLen < len && window.at(from + matchLen) == src[ip + matchLen])
+            matchLen++;
+        if (matchLen < MinMatch) {
+            ip++;
+            continue;
+        }
+        writeSequence(o, src + anchor, ip - anchor, here - from, matchLen);
+        ip += matchLen;
+        anchor = ip;
+    }
+    writeSequence(o, src + anchor, len - anchor, 0, 0);
+    return o.finish();
+}
+
+size_t decompressBody(const char* in, size_t len, char* out, size_t capacity, const CompressionDictionary* dict) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+    Window window(dict, dst);
+    const size_t base = window.dictSize();
+
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < len) {
+        unsigned char token = src[ip++];
+        size_t literalLen = token >> 4;
+        if (literalLen == 15 && !readLength(src, len, ip, literalLen))
+            return 0;
+        if (literalLen > len - ip || literalLen > capacity - op)
+            return 0;
+        std::memcpy(dst + op, src + ip, literalLen);
+        ip += literalLen;
+        op += literalLen;
+        if (ip == len)
+            break;
+
+        if (len - ip < 2)
+            return 0;
+        size_t offset = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+        ip += 2;
+        size_t matchLen = token & 0x0F;
+        if (matchLen == 15 && !readLength(src, len, ip, matchLen))
+            return 0;
+        matchLen += MinMatch;
+        if (offset == 0 || offset > base + op || matchLen > capacity - op)
+            return 0;
+        // Byte by byte: the match may overlap what it is producing.
+        size_t from = base + op - offset;
+        for (size_t i = 0; i < matchLen; i++, op++)
+            dst[op] = window.at(from + i);
+    }
+    return op;
+}
@@ -0,0 +1,73 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "Protocol.hpp"
+
+// Small LZ77 codec for message bodies, in the spirit of LZ4: greedy matches
+// found through one hash table probe, byte-aligned output, no entropy stage.
+// Matches may reach back into a dictionary both sides agree on, which is
+// what makes it pay off on bodies of a few dozen bytes.
+//
+// Stream: sequences of a token byte (literal count in the high nibble,
+// match length - MinMatch in the low one, 15 meaning more length bytes
+// follow, each adding up to 255), the literals, then a 2-byte little-endian
+// match offset back from the current position. The last sequence has
+// literals only.
+
+class CompressionDictionary {
+public:
+    static constexpr size_t MaxSize = 4096;
+    static constexpr unsigned HashBits = 12;
+
+    // `data` must outlive the dictionary; anything past MaxSize is ignored.
+    CompressionDictionary(const unsigned char* data, size_t size);
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    // Hash table already seeded with the dictionary's own positions.
+    const int32_t* table() const { return m_table; }
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+    int32_t m_table[1u << HashBits];
+};
+
+// Dictionary trained on recorded R-Type snapshot bodies; see
+// Bench/train_dictionary.cpp for how to regenerate it.
+const CompressionDictionary &snapshotDictionary();
+
+// Compresses `len` bytes of `in` into `out`. Returns the compressed size, or
+// 0 if it would not fit in `capacity`.
+size_t compressBody(const char* in, size_t len, char* out, size_t capacity,
+                    const CompressionDictionary* dict = nullptr);
+// Returns the decompressed size, or 0 if `in` is malformed, refers outside
+// the dictionary, or expands past `capacity`.
+size_t decompressBody(const char* in, size_t len, char* out, size_t capacity,
+                      const CompressionDictionary* dict = nullptr);
+
+// Which message types a sender compresses, with the snapshot dictionary.
+// A body is only sent compressed when that makes it smaller, so enabling a
+// type never costs bytes on the wire.
+struct CompressionPolicy {
+    uint32_t types = 0;
+
+    void enable(MessageType type, bool on = true) {
+        uint32_t bit = 1u << static_cast<uint8_t>(type);
+        types = on ? (types | bit) : (types & ~bit);
+    }
+    bool covers(uint8_t type) const { return type < 32 && ((types >> type) & 1); }
+};
+
+// Full snapshots, the only bodies large and repetitive enough to be worth
+// it. Deltas are opt-in: they are mostly changed bits already and barely
+// shrink, for a few microseconds per client per tick.
+inline CompressionPolicy defaultCompressionPolicy() {
+    CompressionPolicy policy;
+    policy.enable(MessageType::GAME_STATE);
+    return policy;
+}
+
+#endif // COMPRESSION_HPP
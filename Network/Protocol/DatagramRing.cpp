@@ -0,0 +1,79 @@
+#include "DatagramRing.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+DatagramRing::DatagramRing(size_t slots)
+    : m_storage(slots * maxPacketSize),
+      m_addrs(slots),
+      m_iov(slots),
+      m_headers(slots)
+{
+    for (size_t i = 0; i < slots; i++)
+        resetSlot(i);
+}
+
+void DatagramRing::resetSlot(size_t i) {
+    m_iov[i].iov_base = &m_storage[i * maxPacketSize];
+    m_iov[i].iov_len = maxPacketSize;
+    std::memset(&m_headers[i], 0, sizeof(mmsghdr));
+    m_headers[i].msg_hdr.msg_name = &m_addrs[i];
+    m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    m_headers[i].msg_hdr.msg_iov = &m_iov[i];
+    m_headers[i].msg_hdr.msg_iovlen = 1;
+}
+
+// recvmmsg overwrites the lengths, so every slot is re-armed first.
+void DatagramRing::armReceive() {
+    for (size_t i = 0; i < capacity(); i++) {
+        m_iov[i].iov_len = maxPacketSize;
+        m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+}
+
+int DatagramRing::receive(int sock) {
+    armReceive();
+    return recvmmsg(sock, m_headers.data(), static_cast<unsigned>(capacity()), MSG_WAITFORONE, nullptr);
+}
+
+int DatagramRing::receiveQueued(int sock) {
+    armReceive();
+    int count = recvmmsg(sock, m_headers.data(), static_cast<unsigned>(capacity()), MSG_DONTWAIT, nullptr);
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    return count;
+}
+
+bool DatagramRing::queue(int sock, const sockaddr_in &to, const char* data, size_t len) {
+    if (len > maxPacketSize)
+        return false;
+    bool ok = true;
+    if (m_queued == capacity())
+        ok = flush(sock);
+    size_t i = m_queued++;
+    std::memcpy(&m_storage[i * maxPacketSize], data, len);
+    m_iov[i].iov_len = len;
+    m_addrs[i] = to;
+    m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    return ok;
+}
+
+bool DatagramRing::flush(int sock) {
+    size_t sent = 0;
+    bool ok = true;
+    while (sent < m_queued) {
+        int n = sendmmsg(sock, &m_headers[sent], static_cast<unsigned>(m_queued - sent), 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            // Skip the datagram the kernel refused and keep going with the rest.
+            std::cerr << "[Server] sendmmsg failed: " << std::strerror(errno) << "\n";
+            ok = false;
+            sent++;
+            continue;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    m_queued = 0;
+    return ok;
+}
@@ -0,0 +1,55 @@
+#ifndef DATAGRAM_RING_HPP
+#define DATAGRAM_RING_HPP
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cstddef>
+#include <vector>
+#include "Protocol.hpp"
+
+// Datagram buffers, addresses and the mmsghdr/iovec arrays recvmmsg and
+// sendmmsg need, allocated once and reused slot by slot, so moving a batch
+// of packets costs one syscall and no allocation.
+//
+// A ring is used either for receiving or for sending, from one thread at a
+// time.
+class DatagramRing {
+public:
+    static constexpr size_t DefaultSlots = 64;
+
+    explicit DatagramRing(size_t slots = DefaultSlots);
+
+    size_t capacity() const { return m_addrs.size(); }
+
+    // Blocks until at least one datagram arrives, then takes every other one
+    // already queued, up to capacity(). Returns how many were received, or -1
+    // with errno set.
+    int receive(int sock);
+    // Takes the datagrams already queued, up to capacity(), without
+    // blocking. Returns how many, 0 when there were none, or -1 on error.
+    int receiveQueued(int sock);
+    const char* data(size_t i) const { return &m_storage[i * maxPacketSize]; }
+    size_t length(size_t i) const { return m_headers[i].msg_len; }
+    const sockaddr_in &from(size_t i) const { return m_addrs[i]; }
+
+    // Copies a datagram into the next free slot, flushing first when the
+    // ring is full. Returns false if it is larger than maxPacketSize or the
+    // flush failed.
+    bool queue(int sock, const sockaddr_in &to, const char* data, size_t len);
+    // Sends every queued datagram. Returns false if the socket refused some;
+    // those are dropped, as a lost datagram would be.
+    bool flush(int sock);
+    size_t queued() const { return m_queued; }
+
+private:
+    void resetSlot(size_t i);
+    void armReceive();
+
+    std::vector<char> m_storage;
+    std::vector<sockaddr_in> m_addrs;
+    std::vector<iovec> m_iov;
+    std::vector<mmsghdr> m_headers;
+    size_t m_queued = 0;
+};
+
+#endif // DATAGRAM_RING_HPP
@@ -0,0 +1,103 @@
+#include "Fragmentation.hpp"
+#include "MessageCodec.hpp"
+#include <cstring>
+
+size_t fragmentCount(size_t len) {
+    size_t count = (len + fragmentChunkSize - 1) / fragmentChunkSize;
+    return count <= maxFragments ? count : 0;
+}
+
+size_t encodeFragmentBody(uint32_t group, uint8_t type, const char* body, size_t len, size_t index,
+                          char* out, size_t capacity) {
+    size_t count = fragmentCount(len);
+    if (index >= count)
+        return 0;
+    size_t offset = index * fragmentChunkSize;
+    size_t chunk = (len - offset < fragmentChunkSize) ? len - offset : fragmentChunkSize;
+
+    BitWriter w(out, capacity);
+    w.writeVarUint(group);
+    w.writeBits(type, 8);
+    w.writeBits(static_cast<uint32_t>(index), 8);
+    w.writeBits(static_cast<uint32_t>(count), 8);
+    size_t prefixLen = w.finish();
+    if (prefixLen == 0 || prefixLen + chunk > capacity)
+        return 0;
+    std::memcpy(out + prefixLen, body + offset, chunk);
+    return prefixLen + chunk;
+}
+
+constexpr std::chrono::milliseconds FragmentReassembler::Timeout;
+
+FragmentReassembler::Slot* FragmentReassembler::slotFor(uint32_t group,
+                                                        std::chrono::steady_clock::time_point now) {
+    Slot* victim = nullptr;
+    for (auto &slot : slots) {
+        if (slot.active && slot.group == group)
+            return &slot;
+        if (!slot.active) {
+            if (!victim || victim->active)
+                victim = &slot;
+        } else if (!victim || (victim->active && slot.firstSeen < victim->firstSeen)) {
+            victim = &slot;
+        }
+    }
+    // Reuse a free slot, otherwise give up on the oldest partial packet.
+    victim->active = true;
+    victim->group = group;
+    victim->count = 0;
+    victim->received = 0;
+    victim->receivedMask = 0;
+    victim->lastChunkLen = 0;
+    victim->firstSeen = now;
+    return victim;
+}
+
+bool FragmentReassembler::receive(const char* fragment, size_t fragmentLen,
+                                  std::chrono::steady_clock::time_point now, uint8_t &type, const char* &body, size_t &len) {
+    BitReader r(fragment, fragmentLen);
+    uint32_t group, innerType, index, count;
+    if (!r.readVarUint(group) || !r.readBits(innerType, 8) || !r.readBits(index, 8) || !r.readBits(count, 8))
+        return false;
+    size_t offset = r.bytesRead();
+    if (count == 0 || count > maxFragments || index >= count || offset > fragmentLen)
+        return false;
+    size_t chunk = fragmentLen - offset;
+    bool last = (index == count - 1);
+    if ((!last && chunk != fragmentChunkSize) || (last && (chunk == 0 || chunk > fragmentChunkSize)))
+        return false;
+
+    expire(now);
+    Slot* slot = slotFor(group, now);
+    if (slot->count == 0) {
+        slot->count = static_cast<uint8_t>(count);
+        slot->type = static_cast<uint8_t>(innerType);
+    }
+    if (slot->count != count || slot->type != innerType) {
+        slot->active = false;
+        return false;
+    }
+    uint16_t bit = static_cast<uint16_t>(1u << index);
+    if (slot->receivedMask & bit)
+        return false;
+    std::memcpy(slot->data + index * fragmentChunkSize, fragment + offset, chunk);
+    slot->receivedMask |= bit;
+    slot->received++;
+    if (last)
+        slot->lastChunkLen = chunk;
+    if (slot->received < slot->count)
+        return false;
+
+    slot->active = false;
+    type = slot->type;
+    body = slot->data;
+    len = (slot->count - 1) * fragmentChunkSize + slot->lastChunkLen;
+    return true;
+}
+
+void FragmentReassembler::expire(std::chrono::steady_clock::time_point now) {
+    for (auto &slot : slots) {
+        if (slot.active && now - slot.firstSeen > Timeout)
+            slot.active = false;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef FRAGMENTATION_HPP
+#define FRAGMENTATION_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "Protocol.hpp"
+#include "BitStream.hpp"
+#include "MessageCodec.hpp"
+
+// Splits message bodies too large for one datagram into FRAGMENT messages and
+// puts them back together on the other side.
+//
+// FRAGMENT body: group id (shared by every fragment of one message), the type
+// of the fragmented message, fragment index, fragment count, then a raw slice
+// of the original body. Every field before the slice is a whole number of
+// bytes, so the slice starts byte-aligned. A fragment fills a whole
+// datagram, so each one travels, and is acked, in a packet of its own.
+
+// Room left for the slice once the largest headers and fragment prefix are written.
+constexpr size_t maxFragmentPrefix = 8;
+constexpr size_t fragmentChunkSize = maxMessageBody - maxFragmentPrefix;
+constexpr size_t maxReassembledSize = maxFragments * fragmentChunkSize;
+
+// Number of FRAGMENT messages needed for a `len` byte body, or 0 if too large.
+size_t fragmentCount(size_t len);
+
+// Builds the FRAGMENT body carrying slice `index` of `body`.
+size_t encodeFragmentBody(uint32_t group, uint8_t type, const char* body, size_t len, size_t index,
+                          char* out, size_t capacity);
+
+class FragmentReassembler {
+public:
+    static constexpr size_t Slots = 4;
+    static constexpr std::chrono::milliseconds Timeout{250};
+
+    // Takes one FRAGMENT body. Returns true when it completes its message;
+    // `type`/`body`/`len` then describe the reassembled message, valid until
+    // the next call.
+    bool receive(const char* fragment, size_t fragmentLen,
+                 std::chrono::steady_clock::time_point now, uint8_t &type, const char* &body, size_t &len);
+
+    // Drops messages still incomplete after Timeout.
+    void expire(std::chrono::steady_clock::time_point now);
+
+private:
+    struct Slot {
+        bool active = false;
+        uint32_t group = 0;
+        uint8_t type = 0;
+        uint8_t count = 0;
+        uint8_t received = 0;
+        uint16_t receivedMask = 0;
+        size_t lastChunkLen = 0;
+        std::chrono::steady_clock::time_point firstSeen;
+        char data[maxReassembledSize];
+    };
+    static_assert(maxFragments <= 16, "receivedMask holds one bit per fragment");
+
+    Slot* slotFor(uint32_t group, std::chrono::steady_clock::time_point now);
+
+    Slot slots[Slots];
+};
+
+#endif // FRAGMENTATION_HPP
@@ -0,0 +1,185 @@
+#include "MessageCodec.hpp"
+#include <cstring>
+
+void writePacketHeader(BitWriter &w, const PacketHeader &h) {
+    w.writeVarUint(h.sequence);
+    w.writeVarUint(h.ack);
+    w.writeBits(h.ackBits, 32);
+}
+
+bool readPacketHeader(BitReader &r, PacketHeader &h) {
+    uint32_t sequence, ack, ackBits;
+    if (!r.readVarUint(sequence) || !r.readVarUint(ack) || !r.readBits(ackBits, 32))
+        return false;
+    h.sequence = sequence;
+    h.ack = ack;
+    h.ackBits = ackBits;
+    return true;
+}
+
+void writeMessageHeader(BitWriter &w, const MessageHeader &h, size_t bodyLen) {
+    w.writeBits(h.type, 8);
+    w.writeBits(h.flags, 8);
+    if (h.flags & messageReliable)
+        w.writeVarUint(h.reliableID);
+    w.writeVarUint(static_cast<uint32_t>(bodyLen));
+}
+
+bool MessageFrameReader::next(MessageHeader &h, const char* &body, size_t &bodyLen) {
+    if (m_pos >= m_len)
+        return false;
+    BitReader r(m_data + m_pos, m_len - m_pos);
+    uint32_t type, flags, len, reliableID = 0;
+    if (!r.readBits(type, 8) || !r.readBits(flags, 8))
+        return false;
+    if ((flags & messageReliable) && !r.readVarUint(reliableID))
+        return false;
+    if (!r.readVarUint(len))
+        return false;
+    size_t start = m_pos + r.bytesRead();
+    if (len > m_len - start)
+        return false;
+    h.type = static_cast<uint8_t>(type);
+    h.flags = static_cast<uint8_t>(flags);
+    h.reliableID = reliableID;
+    body = m_data + start;
+    bodyLen = len;
+    m_pos = start + len;
+    return true;
+}
+
+// Clock readings are arbitrary 32-bit values, so they go as they are.
+void writePayload(BitWriter &w, const PingPayload &p) {
+    w.writeVarUint(p.pingSequence);
+    w.writeBits(p.clientSendTime, 32);
+    w.writeBits(p.serverReceiveTime, 32);
+    w.writeBits(p.serverSendTime, 32);
+}
+
+void writePayload(BitWriter &w, const LobbyStatusPayload &p) {
+    w.writeBits(p.totalClients, 8);
+    w.writeBits(p.readyClients, 8);
+}
+
+void writePayload(BitWriter &w, const InputAckPayload &p) {
+    w.writeVarUint(p.snapshotSequence);
+    w.writeVarUint(p.inputTick);
+    w.writeVarUint(p.heldMs);
+}
+
+static_assert(inputRedundancy > 0 && inputRedundancy < 8, "the input count is written in 3 bits");
+
+// netID and the newest tick once, then per input the gap to the previous
+// (newer) tick and the five buttons: about 2 bytes per repeated input.
+void writePayload(BitWriter &w, const PlayerInputBatch &p) {
+    w.writeBits(p.count, 3);
+    if (p.count == 0)
+        return;
+    w.writeVarInt(p.inputs[0].netID);
+    w.writeVarUint(p.inputs[0].tick);
+    for (size_t i = 0; i < p.count && i < inputRedundancy; i++) {
+        const PlayerInputPayload &in = p.inputs[i];
+        if (i > 0)
+            w.writeVarUint(p.inputs[i - 1].tick - in.tick);
+        w.writeBool(in.up);
+        w.writeBool(in.down);
+        w.writeBool(in.left);
+        w.writeBool(in.right);
+        w.writeBool(in.shoot);
+    }
+}
+
+bool readPayload(BitReader &r, PingPayload &p) {
+    uint32_t seq, t1, t2, t3;
+    if (!r.readVarUint(seq) || !r.readBits(t1, 32) || !r.readBits(t2, 32) || !r.readBits(t3, 32))
+        return false;
+    p.pingSequence = seq;
+    p.clientSendTime = t1;
+    p.serverReceiveTime = t2;
+    p.serverSendTime = t3;
+    return true;
+}
+
+bool readPayload(BitReader &r, InputAckPayload &p) {
+    uint32_t seq, tick, held;
+    if (!r.readVarUint(seq) || !r.readVarUint(tick) || !r.readVarUint(held))
+        return false;
+    p.snapshotSequence = seq;
+    p.inputTick = tick;
+    p.heldMs = held;
+    return true;
+}
+
+bool readPayload(BitReader &r, LobbyStatusPayload &p) {
+    uint32_t total, ready;
+    if (!r.readBits(total, 8) || !r.readBits(ready, 8))
+        return false;
+    p.totalClients = static_cast<uint8_t>(total);
+    p.readyClients = static_cast<uint8_t>(ready);
+    return true;
+}
+
+bool readPayload(BitReader &r, PlayerInputBatch &p) {
+    uint32_t count, tick;
+    int32_t netID;
+    if (!r.readBits(count, 3) || count == 0 || count > inputRedundancy ||
+        !r.readVarInt(netID) || !r.readVarUint(tick) || tick == 0)
+        return false;
+    p.count = static_cast<uint8_t>(count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) {
+            uint32_t gap;
+            if (!r.readVarUint(gap) || gap == 0 || gap >= tick)
+                return false;
+            tick -= gap;
+        }
+        bool up, down, left, right, shoot;
+        if (!r.readBool(up) || !r.readBool(down) || !r.readBool(left) ||
+            !r.readBool(right) || !r.readBool(shoot))
+            return false;
+        PlayerInputPayload &in = p.inputs[i];
+        in.netID = netID;
+        in.tick = tick;
+        in.up = up;
+        in.down = down;
+        in.left = left;
+        in.right = right;
+        in.shoot = shoot;
+    }
+    return true;
+}
+
+namespace {
+
+template<typename Payload>
+bool encodeTyped(const void* payload, size_t payloadSize, char* out, size_t capacity, size_t &bodyLen) {
+    if (!payload || payloadSize != sizeof(Payload))
+        return false;
+    Payload p;
+    std::memcpy(&p, payload, sizeof(Payload));
+    bodyLen = encodeBody(p, out, capacity);
+    return bodyLen > 0;
+}
+
+} // namespace
+
+bool encodeMessageBody(uint8_t type, const void* payload, size_t payloadSize,
+                       char* out, size_t capacity, size_t &bodyLen) {
+    bodyLen = 0;
+    switch (type) {
+        case static_cast<uint8_t>(MessageType::PING):
+        case static_cast<uint8_t>(MessageType::PONG):
+            return encodeTyped<PingPayload>(payload, payloadSize, out, capacity, bodyLen);
+        case static_cast<uint8_t>(MessageType::LOBBY_STATUS):
+            return encodeTyped<LobbyStatusPayload>(payload, payloadSize, out, capacity, bodyLen);
+        case static_cast<uint8_t>(MessageType::INPUT_ACK):
+            return encodeTyped<InputAckPayload>(payload, payloadSize, out, capacity, bodyLen);
+        case static_cast<uint8_t>(MessageType::PLAYER_INPUT):
+            return encodeTyped<PlayerInputBatch>(payload, payloadSize, out, capacity, bodyLen);
+        case static_cast<uint8_t>(MessageType::READY):
+        case static_cast<uint8_t>(MessageType::START):
+            return payloadSize == 0;
+        default:
+            return false;
+    }
+}
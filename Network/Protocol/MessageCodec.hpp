@@ -0,0 +1,63 @@
+#ifndef MESSAGE_CODEC_HPP
+#define MESSAGE_CODEC_HPP
+
+#include <cstddef>
+#include "Protocol.hpp"
+#include "BitStream.hpp"
+
+// Wire encoding of the structs in Protocol.hpp. The packed structs are the
+// in-memory representation; on the wire everything is bit-packed.
+
+// Packet and message headers are always a whole number of bytes, so a body
+// encoded on its own can be appended as-is.
+constexpr size_t maxPacketHeaderSize = 14;
+constexpr size_t maxMessageHeaderSize = 10;
+// Largest body that fits in a datagram next to the headers.
+constexpr size_t maxMessageBody = maxPacketSize - maxPacketHeaderSize - maxMessageHeaderSize;
+
+void writePacketHeader(BitWriter &w, const PacketHeader &h);
+bool readPacketHeader(BitReader &r, PacketHeader &h);
+
+// Writes the framing of one message: its header and the length of the body
+// that follows.
+void writeMessageHeader(BitWriter &w, const MessageHeader &h, size_t bodyLen);
+
+// Walks the messages of a datagram once its packet header has been read.
+class MessageFrameReader {
+public:
+    MessageFrameReader(const char* datagram, size_t len, size_t offset)
+        : m_data(datagram), m_len(len), m_pos(offset) {}
+
+    // Returns false at the end of the datagram or on a malformed frame.
+    bool next(MessageHeader &h, const char* &body, size_t &bodyLen);
+
+private:
+    const char* m_data;
+    size_t m_len;
+    size_t m_pos;
+};
+
+void writePayload(BitWriter &w, const PingPayload &p);
+void writePayload(BitWriter &w, const LobbyStatusPayload &p);
+void writePayload(BitWriter &w, const InputAckPayload &p);
+void writePayload(BitWriter &w, const PlayerInputBatch &p);
+
+bool readPayload(BitReader &r, PingPayload &p);
+bool readPayload(BitReader &r, LobbyStatusPayload &p);
+bool readPayload(BitReader &r, InputAckPayload &p);
+bool readPayload(BitReader &r, PlayerInputBatch &p);
+
+template<typename Payload>
+size_t encodeBody(const Payload &payload, char* out, size_t capacity) {
+    BitWriter w(out, capacity);
+    writePayload(w, payload);
+    return w.finish();
+}
+
+// Encodes the body of a message whose payload is given as raw struct bytes,
+// picking the payload type from `type`. Returns false if the size does not
+// match the type; header-only messages produce an empty body.
+bool encodeMessageBody(uint8_t type, const void* payload, size_t payloadSize,
+                       char* out, size_t capacity, size_t &bodyLen);
+
+#endif // MESSAGE_CODEC_HPP
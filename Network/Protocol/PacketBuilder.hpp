@@ -0,0 +1,88 @@
+#ifndef PACKET_BUILDER_HPP
+#define PACKET_BUILDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "Protocol.hpp"
+#include "BitStream.hpp"
+#include "MessageCodec.hpp"
+#include "Reliability.hpp"
+
+// Collects the messages queued for one peer into as few datagrams as
+// possible. Messages are appended until the next one would push the datagram
+// past maxPacketSize; the datagram is then stamped by the peer's channel and
+// handed to `send(data, len)`, which returns false if the socket refused it.
+class PacketBuilder {
+public:
+    static constexpr size_t Budget = maxPacketSize - maxPacketHeaderSize;
+
+    // Appends one message. A packet carries at most one tag, so a message
+    // with a different tag than what is buffered starts a new datagram.
+    // Returns false if the message can never fit or a send failed.
+    template<typename Send>
+    bool add(ReliableChannel &channel, const MessageHeader &h, const char* body, size_t len,
+             Send &&send, uint32_t tag = 0);
+
+    // Sends the buffered messages as one datagram. With nothing buffered,
+    // sends a bare ack packet if `ackOnly`, otherwise nothing.
+    template<typename Send>
+    bool flush(ReliableChannel &channel, Send &&send, bool ackOnly = false);
+
+    bool empty() const { return m_len == 0; }
+
+private:
+    char m_data[Budget];
+    size_t m_len = 0;
+    uint32_t m_tag = 0;
+    uint32_t m_reliable[ReliableChannel::MaxReliablePerPacket];
+    size_t m_reliableCount = 0;
+};
+
+template<typename Send>
+bool PacketBuilder::add(ReliableChannel &channel, const MessageHeader &h, const char* body, size_t len,
+                        Send &&send, uint32_t tag) {
+    char frame[maxMessageHeaderSize];
+    BitWriter w(frame, sizeof(frame));
+    writeMessageHeader(w, h, len);
+    size_t frameLen = w.finish();
+    if (frameLen == 0 || frameLen + len > Budget)
+        return false;
+
+    bool reliable = (h.flags & messageReliable) != 0;
+    bool full = m_len + frameLen + len > Budget ||
+                (tag && m_tag && tag != m_tag) ||
+                (reliable && m_reliableCount == ReliableChannel::MaxReliablePerPacket);
+    if (full && !flush(channel, send))
+        return false;
+
+    std::memcpy(m_data + m_len, frame, frameLen);
+    if (len > 0)
+        std::memcpy(m_data + m_len + frameLen, body, len);
+    m_len += frameLen + len;
+    if (tag)
+        m_tag = tag;
+    if (reliable)
+        m_reliable[m_reliableCount++] = h.reliableID;
+    return true;
+}
+
+template<typename Send>
+bool PacketBuilder::flush(ReliableChannel &channel, Send &&send, bool ackOnly) {
+    if (m_len == 0 && !ackOnly)
+        return true;
+    PacketHeader h;
+    channel.stamp(h, m_tag, m_reliable, m_reliableCount);
+    char packet[maxPacketSize];
+    BitWriter w(packet, sizeof(packet));
+    writePacketHeader(w, h);
+    size_t headerLen = w.finish();
+    std::memcpy(packet + headerLen, m_data, m_len);
+    size_t total = headerLen + m_len;
+    m_len = 0;
+    m_tag = 0;
+    m_reliableCount = 0;
+    return headerLen > 0 && send(static_cast<const char*>(packet), total);
+}
+
+#endif // PACKET_BUILDER_HPP
@@ -1,36 +1,87 @@
 #ifndef PROTOCOL_HPP
 #define PROTOCOL_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <chrono>
 
+// Every datagram stays below this so the IP layer never has to fragment;
+// larger snapshots are split by the fragmentation layer instead.
+constexpr size_t maxPacketSize = 1200;
+
+// Simulation and snapshot rate of the server, in ticks per second.
+constexpr int serverTickRate = 20;
+constexpr size_t maxFragments = 16;
+
+constexpr size_t maxSnapshotPlayers = 4;
+constexpr size_t maxSnapshotEnemies = 128;
+constexpr size_t maxSnapshotBullets = 255;
+
+// Inputs repeated in every PLAYER_INPUT message.
+constexpr size_t inputRedundancy = 4;
+
 #pragma pack(push, 1)
 
 enum class MessageType : uint8_t {
     READY         = 1,
     START         = 2,
-    ACK           = 5,
     PING          = 6,
     PONG          = 7,
     GAME_STATE    = 8,
     LOBBY_STATUS  = 10,
-    PLAYER_INPUT  = 11
+    PLAYER_INPUT  = 11,
+    GAME_STATE_DELTA = 12,
+    FRAGMENT      = 13,
+    INPUT_ACK     = 14
 };
 
-struct MessageHeader {
-    uint8_t  type;
+// Bit 0 of MessageHeader::flags: the message is retransmitted until acked.
+constexpr uint8_t messageReliable = 1;
+// Bit 1: unreliable, but the sender wants to hear about it soon (snapshots,
+// whose acks pick the next delta baseline).
+constexpr uint8_t messageNeedsAck = 2;
+// Bit 2: the body went through compressBody() with the snapshot dictionary
+// (Compression.hpp). On FRAGMENT messages it describes the reassembled body.
+constexpr uint8_t messageCompressed = 4;
+
+// A datagram is a PacketHeader followed by any number of messages, each a
+// MessageHeader, the length of its body, then the body. Everything queued
+// for one peer during a tick shares a datagram, up to maxPacketSize.
+//
+// The packet header carries the sender's packet sequence plus what it has
+// received from the peer: the latest sequence and a bitfield where bit i
+// means `ack - 1 - i` arrived too. A packet with no messages is a bare ack.
+struct PacketHeader {
     uint32_t sequence;
-    uint32_t timestamp;
-    uint8_t  flags;
+    uint32_t ack;
+    uint32_t ackBits;
 };
 
-struct AckPayload {
-    uint32_t ackSequence;
+struct MessageHeader {
+    uint8_t  type;
+    uint8_t  flags;
+    uint32_t reliableID;    // only on the wire when flags & messageReliable
 };
 
+// PING carries the client's send time; the server echoes it in the PONG
+// with its own receive and send times, all getCurrentTimeMS() of the host
+// that took them. That is one NTP exchange: see ClockSync.
 struct PingPayload {
     uint32_t pingSequence;
+    uint32_t clientSendTime;
+    uint32_t serverReceiveTime;     // 0 in PING
+    uint32_t serverSendTime;        // 0 in PING
+};
+
+// Sent with each snapshot to the client whose player it contains: the
+// newest of its inputs the simulation had applied when the snapshot was
+// taken, and for how long the game had been moving the player with it.
+// The client replays the rest of its inputs on top of the snapshot.
+struct InputAckPayload {
+    uint32_t snapshotSequence;
+    uint32_t inputTick;
+    uint32_t heldMs;
 };
 
 struct LobbyStatusPayload {
@@ -40,6 +91,7 @@ struct LobbyStatusPayload {
 
 struct PlayerInputPayload {
     int32_t netID;
+    uint32_t tick;      // client input tick, starts at 1 and only grows
     bool up;
     bool down;
     bool left;
@@ -47,6 +99,13 @@ struct PlayerInputPayload {
     bool shoot;
 };
 
+// PLAYER_INPUT body: the newest input followed by the ones sent just before
+// it, so the inputs of a lost packet still arrive with the next one.
+struct PlayerInputBatch {
+    uint8_t count;
+    PlayerInputPayload inputs[inputRedundancy];   // newest first
+};
+
 struct BulletState {
     int32_t bulletID;
     float   x;
@@ -66,7 +125,7 @@ struct EnemyState {
 
 struct GameStatePayload {
     uint8_t numEnemies;
-    EnemyState enemies[32];
+    EnemyState enemies[maxSnapshotEnemies];
 
     uint8_t numPlayers;
     struct PlayerState {
@@ -74,14 +133,15 @@ struct GameStatePayload {
         float   x;
         float   y;
         int32_t health;
-    } players[4];
+    } players[maxSnapshotPlayers];
 
     uint8_t numBullets;
-    BulletState bullets[32];
+    BulletState bullets[maxSnapshotBullets];
 };
 
 #pragma pack(pop)
 
+
 inline uint32_t getCurrentTimeMS() {
     using ms = std::chrono::milliseconds;
     return static_cast<uint32_t>(
@@ -0,0 +1,116 @@
+#include "Reliability.hpp"
+#include <cmath>
+#include <cstring>
+
+constexpr ReliableChannel::Millis ReliableChannel::InitialRto;
+constexpr ReliableChannel::Millis ReliableChannel::MinRto;
+constexpr ReliableChannel::Millis ReliableChannel::MaxRto;
+constexpr ReliableChannel::Millis ReliableChannel::WheelTick;
+constexpr ReliableChannel::Millis ReliableChannel::AckDelay;
+
+ReliableChannel::ReliableChannel() {
+    for (auto &slot : wheel)
+        slot = NoSlot;
+}
+
+void ReliableChannel::stamp(PacketHeader &h, uint32_t tag, const uint32_t* reliableIDs, size_t reliableCount) {
+    h.sequence = nextSequence++;
+    if (nextSequence == 0)
+        nextSequence = 1;
+    h.ack = remoteSequence;
+    h.ackBits = 0;
+    for (uint32_t i = 0; i < 32 && remoteSequence != 0; i++) {
+        uint32_t sequence = remoteSequence - 1 - i;
+        if (received[sequence % WindowSize] == sequence)
+            h.ackBits |= 1u << i;
+    }
+    ackPending = false;
+
+    SentPacket &p = sent[h.sequence % WindowSize];
+    if (p.sequence != 0 && !p.acked)
+        lost++;
+    p.sequence = h.sequence;
+    p.tag = tag;
+    p.reliableCount = 0;
+    for (size_t i = 0; i < reliableCount && i < MaxReliablePerPacket; i++)
+        p.reliableIDs[p.reliableCount++] = reliableIDs[i];
+    p.acked = false;
+    p.sendTime = Clock::now();
+}
+
+bool ReliableChannel::sendReliable(uint8_t type, const char* body, size_t len) {
+    if (len > MaxReliableBody || nextReliableID - oldestReliableID >= MaxPendingReliable)
+        return false;
+    PendingReliable &p = pending[nextReliableID % MaxPendingReliable];
+    p.id = nextReliableID++;
+    p.active = true;
+    p.type = type;
+    p.len = static_cast<uint8_t>(len);
+    p.resends = 0;
+    if (len > 0)
+        std::memcpy(p.body, body, len);
+    return true;
+}
+
+void ReliableChannel::retireReliable(uint32_t reliableID) {
+    int16_t index = static_cast<int16_t>(reliableID % MaxPendingReliable);
+    PendingReliable &p = pending[index];
+    if (!p.active || p.id != reliableID)
+        return;
+    unlink(index);
+    p.active = false;
+    while (oldestReliableID != nextReliableID && !pending[oldestReliableID % MaxPendingReliable].active)
+        oldestReliableID++;
+}
+
+bool ReliableChannel::acceptReliable(uint32_t reliableID) {
+    uint32_t &slot = receivedReliable[reliableID % WindowSize];
+    if (slot == reliableID)
+        return false;
+    slot = reliableID;
+    return true;
+}
+
+void ReliableChannel::sampleRtt(Clock::duration rtt) {
+    float r = std::chrono::duration<float, std::milli>(rtt).count();
+    if (srttMs == 0.0f) {
+        srttMs = r;
+        rttvarMs = r / 2.0f;
+    } else {
+        rttvarMs = 0.75f * rttvarMs + 0.25f * std::fabs(srttMs - r);
+        srttMs = 0.875f * srttMs + 0.125f * r;
+    }
+    float granularity = static_cast<float>(WheelTick.count());
+    auto ms = static_cast<Millis::rep>(srttMs + std::max(granularity, 4.0f * rttvarMs));
+    rto = std::min(std::max(Millis(ms), MinRto), MaxRto);
+}
+
+void ReliableChannel::link(int64_t due, int16_t index) {
+    PendingReliable &p = pending[index];
+    int16_t slot = static_cast<int16_t>(due % static_cast<int64_t>(WheelSlots));
+    p.due = due;
+    p.slot = slot;
+    p.prev = -1;
+    p.next = wheel[slot];
+    if (wheel[slot] >= 0)
+        pending[wheel[slot]].prev = index;
+    wheel[slot] = index;
+}
+
+void ReliableChannel::unlink(int16_t index) {
+    PendingReliable &p = pending[index];
+    if (p.slot == NoSlot)
+        return;
+    if (p.prev >= 0)
+        pending[p.prev].next = p.next;
+    else
+        wheel[p.slot] = p.next;
+    if (p.next >= 0)
+        pending[p.next].prev = p.prev;
+    p.slot = NoSlot;
+    p.prev = p.next = -1;
+}
+
+int64_t ReliableChannel::wheelTick(Clock::time_point t) {
+    return std::chrono::duration_cast<Millis>(t.time_since_epoch()).count() / WheelTick.count();
+}
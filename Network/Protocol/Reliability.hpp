@@ -0,0 +1,243 @@
+#ifndef RELIABILITY_HPP
+#define RELIABILITY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "Protocol.hpp"
+
+// True if sequence `a` is newer than `b`, allowing for wrap-around.
+inline bool sequenceNewer(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) > 0;
+}
+
+// Per-peer packet acknowledgement. Every outgoing packet header is stamped
+// with our next sequence number plus the ack/ackBits of what the peer sent
+// us, so acks ride along with normal traffic. Packets themselves are never
+// resent; only messages queued with sendReliable() are, in a fresh packet
+// each time, until one of the packets carrying them is acked.
+//
+// Resends follow RFC 6298: acked packets give RTT samples for SRTT/RTTVAR,
+// each message starts with the resulting RTO, doubles it on every resend and
+// is dropped after MaxResends. Waiting messages sit in a hashed timer wheel
+// wide enough for MaxRto, so a flush only touches the slots that came due.
+// Each resend is a new packet, so every ack is an unambiguous RTT sample.
+class ReliableChannel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Millis = std::chrono::milliseconds;
+
+    static constexpr size_t WindowSize = 256;
+    static constexpr size_t MaxPendingReliable = 32;
+    static constexpr size_t MaxReliableBody = 64;
+    static constexpr size_t MaxReliablePerPacket = 8;
+    static constexpr Millis InitialRto{200};
+    static constexpr Millis MinRto{30};
+    static constexpr Millis MaxRto{2000};
+    static constexpr uint8_t MaxResends = 8;
+    static constexpr Millis WheelTick{10};
+    static constexpr size_t WheelSlots = 256;
+    static_assert(MaxRto < WheelTick * WheelSlots, "a timer must never wrap the wheel");
+    // How long a receipt waits for outgoing traffic to carry its ack before
+    // a bare ack packet is sent on its own.
+    static constexpr Millis AckDelay{20};
+
+    ReliableChannel();
+
+    // Fills in sequence, ack and ackBits. `tag` is handed back to the
+    // receive() callback if this packet is acked; 0 means nobody cares.
+    // `reliableIDs` are the reliable messages the packet carries.
+    void stamp(PacketHeader &h, uint32_t tag = 0, const uint32_t* reliableIDs = nullptr, size_t reliableCount = 0);
+
+    // Records an incoming header and processes the acks it carries, calling
+    // onAcked(tag) once for each tagged packet of ours newly acknowledged.
+    // Returns false for duplicates and packets too old to track; those must
+    // be dropped.
+    template<typename OnAcked>
+    bool receive(const PacketHeader &h, Clock::time_point now, OnAcked onAcked);
+    bool receive(const PacketHeader &h, Clock::time_point now) {
+        return receive(h, now, [](uint32_t) {});
+    }
+
+    // A received message wants its packet acked soon (reliable messages and
+    // snapshots); see needsAck().
+    void requestAck(Clock::time_point now) {
+        if (!ackPending) {
+            ackPending = true;
+            ackPendingSince = now;
+        }
+    }
+
+    // Queues a message to be resent until acked. Returns false if the body is
+    // too large or MaxPendingReliable messages are already in flight.
+    bool sendReliable(uint8_t type, const char* body, size_t len);
+
+    // Hands every queued message that was never sent or whose timer expired
+    // to `emit(header, body, len)`, which must put it in the next packet.
+    template<typename Emit>
+    void flushReliable(Clock::time_point now, Emit emit);
+
+    // Reliable messages can arrive more than once; true only the first time.
+    bool acceptReliable(uint32_t reliableID);
+
+    // True when something we received asked for an ack and no packet has
+    // carried it for AckDelay.
+    bool needsAck(Clock::time_point now) const {
+        return ackPending && now - ackPendingSince >= AckDelay;
+    }
+
+    // Packets that left the send window without being acked.
+    uint32_t lostPackets() const { return lost; }
+    // Reliable messages dropped after MaxResends unacked copies.
+    uint32_t abandonedMessages() const { return abandoned; }
+    // Smoothed round-trip time, 0 until the first sample.
+    float smoothedRttMs() const { return srttMs; }
+    Millis retransmitTimeout() const { return rto; }
+
+private:
+    struct SentPacket {
+        uint32_t sequence = 0;
+        uint32_t tag = 0;
+        uint8_t reliableCount = 0;
+        uint32_t reliableIDs[MaxReliablePerPacket];
+        bool acked = true;
+        Clock::time_point sendTime;
+    };
+    // Once sent, linked into the wheel slot of its next resend through
+    // prev/next, which index `pending`. Indices rather than pointers keep
+    // the channel copyable.
+    struct PendingReliable {
+        uint32_t id = 0;
+        bool active = false;
+        uint8_t type = 0;
+        uint8_t len = 0;
+        uint8_t resends = 0;
+        Millis rto{0};
+        int16_t prev = -1;
+        int16_t next = -1;
+        int16_t slot = NoSlot;
+        int64_t due = 0;      // wheel tick of the next resend
+        char body[MaxReliableBody];
+    };
+
+    void retireReliable(uint32_t reliableID);
+    void sampleRtt(Clock::duration rtt);
+    static constexpr int16_t NoSlot = -1;
+    // Schedules pending[index] for wheel tick `due`.
+    void link(int64_t due, int16_t index);
+    void unlink(int16_t index);
+    static int64_t wheelTick(Clock::time_point t);
+    // Emits pending[index] once and schedules its next resend.
+    template<typename Emit>
+    void transmit(int16_t index, Clock::time_point now, Emit &emit);
+
+    uint32_t nextSequence = 1;
+    SentPacket sent[WindowSize];
+    uint32_t lost = 0;
+
+    uint32_t remoteSequence = 0;
+    uint32_t received[WindowSize] = {};
+    bool ackPending = false;
+    Clock::time_point ackPendingSince;
+
+    uint32_t nextReliableID = 1;
+    uint32_t oldestReliableID = 1;
+    PendingReliable pending[MaxPendingReliable];
+    uint32_t receivedReliable[WindowSize] = {};
+    uint32_t abandoned = 0;
+
+    uint32_t firstUnsentID = 1;
+    int16_t wheel[WheelSlots];
+    int64_t wheelNow = -1;    // next tick to process; -1 until the first flush
+
+    float srttMs = 0.0f;
+    float rttvarMs = 0.0f;
+    Millis rto = InitialRto;
+};
+
+template<typename OnAcked>
+bool ReliableChannel::receive(const PacketHeader &h, Clock::time_point now, OnAcked onAcked) {
+    if (h.sequence == 0)
+        return false;
+    if (remoteSequence != 0 && !sequenceNewer(h.sequence, remoteSequence) &&
+        remoteSequence - h.sequence >= WindowSize)
+        return false;
+    uint32_t &slot = received[h.sequence % WindowSize];
+    if (slot == h.sequence)
+        return false;
+    slot = h.sequence;
+    if (remoteSequence == 0 || sequenceNewer(h.sequence, remoteSequence))
+        remoteSequence = h.sequence;
+
+    auto ackOne = [&](uint32_t sequence) {
+        SentPacket &p = sent[sequence % WindowSize];
+        if (p.sequence != sequence || p.acked)
+            return;
+        p.acked = true;
+        if (sequence == h.ack)
+            sampleRtt(now - p.sendTime);
+        for (size_t i = 0; i < p.reliableCount; i++)
+            retireReliable(p.reliableIDs[i]);
+        if (p.tag)
+            onAcked(p.tag);
+    };
+    if (h.ack == 0)
+        return true;
+    ackOne(h.ack);
+    for (uint32_t i = 0; i < 32; i++) {
+        if (h.ackBits & (1u << i))
+            ackOne(h.ack - 1 - i);
+    }
+    return true;
+}
+
+template<typename Emit>
+void ReliableChannel::transmit(int16_t index, Clock::time_point now, Emit &emit) {
+    PendingReliable &p = pending[index];
+    MessageHeader h;
+    h.type = p.type;
+    h.flags = messageReliable;
+    h.reliableID = p.id;
+    emit(h, p.body, static_cast<size_t>(p.len));
+    link(wheelTick(now + p.rto), index);
+}
+
+template<typename Emit>
+void ReliableChannel::flushReliable(Clock::time_point now, Emit emit) {
+    int64_t target = wheelTick(now);
+    if (wheelNow < 0 || target - wheelNow >= static_cast<int64_t>(WheelSlots))
+        wheelNow = target - static_cast<int64_t>(WheelSlots) + 1;
+
+    // Only timers due by `target` fire. Normally that is every timer in the
+    // slots swept; catching up after a long stall sweeps the whole wheel,
+    // and a resend scheduled during the sweep can land in a slot still to
+    // come, so the rest stay where they are.
+    for (; wheelNow <= target; wheelNow++) {
+        int16_t next = wheel[wheelNow % WheelSlots];
+        while (next >= 0) {
+            int16_t index = next;
+            PendingReliable &p = pending[index];
+            next = p.next;
+            if (p.due > target)
+                continue;
+            unlink(index);
+            if (p.resends >= MaxResends) {
+                abandoned++;
+                retireReliable(p.id);
+                continue;
+            }
+            p.resends++;
+            p.rto = std::min(p.rto * 2, MaxRto);
+            transmit(index, now, emit);
+        }
+    }
+    // Messages queued since the last flush are always the newest ids.
+    for (; firstUnsentID != nextReliableID; firstUnsentID++) {
+        int16_t index = static_cast<int16_t>(firstUnsentID % MaxPendingReliable);
+        pending[index].rto = rto;
+        transmit(index, now, emit);
+    }
+}
+
+#endif // RELIABILITY_HPP
@@ -0,0 +1,416 @@
+#include "SnapshotDelta.hpp"
+#include <algorithm>
+#include <cstring>
+
+void SnapshotRing::store(uint32_t sequence, const GameStatePayload &payload) {
+    Slot &slot = slots[sequence % Size];
+    slot.sequence = sequence;
+    slot.valid = true;
+    slot.payload = payload;
+}
+
+const GameStatePayload* SnapshotRing::find(uint32_t sequence) const {
+    const Slot &slot = slots[sequence % Size];
+    if (!slot.valid || slot.sequence != sequence)
+        return nullptr;
+    return &slot.payload;
+}
+
+namespace {
+
+using PlayerState = GameStatePayload::PlayerState;
+
+constexpr unsigned enemyTypeBits = 2;
+
+// Per entity kind: its id and, for each replicated field, how to compare
+// it at wire precision and how to read/write it.
+struct PlayerFields {
+    using Type = PlayerState;
+    static constexpr unsigned count = 3;
+    static int32_t id(const Type &e) { return e.playerID; }
+    static void setID(Type &e, int32_t id) { e.playerID = id; }
+    static bool equal(const Type &a, const Type &b, unsigned f) {
+        switch (f) {
+            case 0: return quantize(a.x, positionRange) == quantize(b.x, positionRange);
+            case 1: return quantize(a.y, positionRange) == quantize(b.y, positionRange);
+            default: return a.health == b.health;
+        }
+    }
+    static void write(BitWriter &w, const Type &e, unsigned f) {
+        switch (f) {
+            case 0: w.writeQuantized(e.x, positionRange); break;
+            case 1: w.writeQuantized(e.y, positionRange); break;
+            default: w.writeVarInt(e.health); break;
+        }
+    }
+    static bool read(BitReader &r, Type &e, unsigned f) {
+        float v;
+        int32_t i;
+        switch (f) {
+            case 0: if (!r.readQuantized(v, positionRange)) return false; e.x = v; return true;
+            case 1: if (!r.readQuantized(v, positionRange)) return false; e.y = v; return true;
+            default: if (!r.readVarInt(i)) return false; e.health = i; return true;
+        }
+    }
+};
+
+struct EnemyFields {
+    using Type = EnemyState;
+    static constexpr unsigned count = 4;
+    static int32_t id(const Type &e) { return e.enemyID; }
+    static void setID(Type &e, int32_t id) { e.enemyID = id; }
+    static bool equal(const Type &a, const Type &b, unsigned f) {
+        switch (f) {
+            case 0: return quantize(a.x, positionRange) == quantize(b.x, positionRange);
+            case 1: return quantize(a.y, positionRange) == quantize(b.y, positionRange);
+            case 2: return a.health == b.health;
+            default: return a.type == b.type;
+        }
+    }
+    static void write(BitWriter &w, const Type &e, unsigned f) {
+        switch (f) {
+            case 0: w.writeQuantized(e.x, positionRange); break;
+            case 1: w.writeQuantized(e.y, positionRange); break;
+            case 2: w.writeVarInt(e.health); break;
+            default: w.writeBits(e.type, enemyTypeBits); break;
+        }
+    }
+    static bool read(BitReader &r, Type &e, unsigned f) {
+        float v;
+        int32_t i;
+        uint32_t u;
+        switch (f) {
+            case 0: if (!r.readQuantized(v, positionRange)) return false; e.x = v; return true;
+            case 1: if (!r.readQuantized(v, positionRange)) return false; e.y = v; return true;
+            case 2: if (!r.readVarInt(i)) return false; e.health = i; return true;
+            default: if (!r.readBits(u, enemyTypeBits)) return false; e.type = static_cast<uint8_t>(u); return true;
+        }
+    }
+};
+
+struct BulletFields {
+    using Type = BulletState;
+    static constexpr unsigned count = 5;
+    static int32_t id(const Type &e) { return e.bulletID; }
+    static void setID(Type &e, int32_t id) { e.bulletID = id; }
+    static bool equal(const Type &a, const Type &b, unsigned f) {
+        switch (f) {
+            case 0: return quantize(a.x, positionRange) == quantize(b.x, positionRange);
+            case 1: return quantize(a.y, positionRange) == quantize(b.y, positionRange);
+            case 2: return quantize(a.vx, velocityRange) == quantize(b.vx, velocityRange);
+            case 3: return quantize(a.vy, velocityRange) == quantize(b.vy, velocityRange);
+            default: return a.ownerID == b.ownerID;
+        }
+    }
+    static void write(BitWriter &w, const Type &e, unsigned f) {
+        switch (f) {
+            case 0: w.writeQuantized(e.x, positionRange); break;
+            case 1: w.writeQuantized(e.y, positionRange); break;
+            case 2: w.writeQuantized(e.vx, velocityRange); break;
+            case 3: w.writeQuantized(e.vy, velocityRange); break;
+            default: w.writeVarInt(e.ownerID); break;
+        }
+    }
+    static bool read(BitReader &r, Type &e, unsigned f) {
+        float v;
+        int32_t i;
+        switch (f) {
+            case 0: if (!r.readQuantized(v, positionRange)) return false; e.x = v; return true;
+            case 1: if (!r.readQuantized(v, positionRange)) return false; e.y = v; return true;
+            case 2: if (!r.readQuantized(v, velocityRange)) return false; e.vx = v; return true;
+            case 3: if (!r.readQuantized(v, velocityRange)) return false; e.vy = v; return true;
+            default: if (!r.readVarInt(i)) return false; e.ownerID = i; return true;
+        }
+    }
+};
+
+template<typename Fields>
+void sortById(const typename Fields::Type* items, uint8_t count, uint8_t* order) {
+    for (unsigned i = 0; i < count; i++)
+        order[i] = static_cast<uint8_t>(i);
+    std::sort(order, order + count, [&](uint8_t a, uint8_t b) {
+        return Fields::id(items[a]) < Fields::id(items[b]);
+    });
+}
+
+// Ids are written in ascending order as the gap from the previous one,
+// which keeps most of them to a single varint byte.
+class IdWriter {
+public:
+    explicit IdWriter(BitWriter &w) : m_w(w) {}
+    void write(int32_t id) {
+        m_w.writeVarInt(static_cast<int32_t>(static_cast<uint32_t>(id) - static_cast<uint32_t>(m_prev)));
+        m_prev = id;
+    }
+private:
+    BitWriter &m_w;
+    int32_t m_prev = 0;
+};
+
+class IdReader {
+public:
+    explicit IdReader(BitReader &r) : m_r(r) {}
+    bool read(int32_t &id) {
+        int32_t gap;
+        if (!m_r.readVarInt(gap))
+            return false;
+        id = static_cast<int32_t>(static_cast<uint32_t>(m_prev) + static_cast<uint32_t>(gap));
+        m_prev = id;
+        return true;
+    }
+private:
+    BitReader &m_r;
+    int32_t m_prev = 0;
+};
+
+template<typename Fields>
+void encodeList(BitWriter &w, const typename Fields::Type* base, uint8_t baseCount,
+                const typename Fields::Type* cur, uint8_t curCount) {
+    using T = typename Fields::Type;
+    uint8_t baseOrder[256];
+    uint8_t curOrder[256];
+    sortById<Fields>(base, baseCount, baseOrder);
+    sortById<Fields>(cur, curCount, curOrder);
+
+    // Despawns: ids present in the baseline but not in the current snapshot.
+    int32_t removed[256];
+    unsigned removedCount = 0;
+    unsigned ci = 0;
+    for (unsigned bi = 0; bi < baseCount; bi++) {
+        int32_t baseID = Fields::id(base[baseOrder[bi]]);
+        while (ci < curCount && Fields::id(cur[curOrder[ci]]) < baseID)
+            ci++;
+        if (ci >= curCount || Fields::id(cur[curOrder[ci]]) != baseID)
+            removed[removedCount++] = baseID;
+    }
+    w.writeBits(removedCount, 8);
+    IdWriter removedIDs(w);
+    for (unsigned i = 0; i < removedCount; i++)
+        removedIDs.write(removed[i]);
+
+    // Spawns and updates: every field is sent for new ids, only the
+    // differing ones for ids that were already in the baseline.
+    const T* changed[256];
+    uint8_t masks[256];
+    unsigned changedCount = 0;
+    unsigned bi = 0;
+    for (ci = 0; ci < curCount; ci++) {
+        const T &c = cur[curOrder[ci]];
+        while (bi < baseCount && Fields::id(base[baseOrder[bi]]) < Fields::id(c))
+            bi++;
+        const T* b = (bi < baseCount && Fields::id(base[baseOrder[bi]]) == Fields::id(c)) ? &base[baseOrder[bi]] : nullptr;
+        uint8_t mask = 0;
+        for (unsigned f = 0; f < Fields::count; f++) {
+            if (!b || !Fields::equal(c, *b, f))
+                mask |= static_cast<uint8_t>(1u << f);
+        }
+        if (mask == 0)
+            continue;
+        changed[changedCount] = &c;
+        masks[changedCount] = mask;
+        changedCount++;
+    }
+    w.writeBits(changedCount, 8);
+    IdWriter changedIDs(w);
+    for (unsigned i = 0; i < changedCount; i++) {
+        changedIDs.write(Fields::id(*changed[i]));
+        w.writeBits(masks[i], Fields::count);
+        for (unsigned f = 0; f < Fields::count; f++) {
+            if (masks[i] & (1u << f))
+                Fields::write(w, *changed[i], f);
+        }
+    }
+}
+
+template<typename Fields>
+bool decodeList(BitReader &r, const typename Fields::Type* base, uint8_t baseCount,
+                typename Fields::Type* out, uint8_t &outCount, unsigned capacity) {
+    using T = typename Fields::Type;
+    uint8_t baseOrder[256];
+    sortById<Fields>(base, baseCount, baseOrder);
+
+    uint32_t removedCount;
+    int32_t removed[256];
+    if (!r.readBits(removedCount, 8))
+        return false;
+    IdReader removedIDs(r);
+    for (unsigned i = 0; i < removedCount; i++) {
+        if (!removedIDs.read(removed[i]))
+            return false;
+    }
+
+    // Baseline entities minus despawns, still sorted by id.
+    unsigned count = 0;
+    unsigned ri = 0;
+    for (unsigned bi = 0; bi < baseCount; bi++) {
+        const T &b = base[baseOrder[bi]];
+        while (ri < removedCount && removed[ri] < Fields::id(b))
+            ri++;
+        if (ri < removedCount && removed[ri] == Fields::id(b))
+            continue;
+        out[count++] = b;
+    }
+
+    uint32_t changedCount;
+    if (!r.readBits(changedCount, 8))
+        return false;
+    IdReader changedIDs(r);
+    unsigned kept = count;
+    unsigned ki = 0;
+    for (unsigned i = 0; i < changedCount; i++) {
+        int32_t entityID;
+        uint32_t mask;
+        if (!changedIDs.read(entityID) || !r.readBits(mask, Fields::count))
+            return false;
+        while (ki < kept && Fields::id(out[ki]) < entityID)
+            ki++;
+        T* target;
+        if (ki < kept && Fields::id(out[ki]) == entityID) {
+            target = &out[ki];
+        } else {
+            if (count >= capacity)
+                return false;
+            target = &out[count++];
+            std::memset(target, 0, sizeof(T));
+            Fields::setID(*target, entityID);
+        }
+        for (unsigned f = 0; f < Fields::count; f++) {
+            if ((mask & (1u << f)) && !Fields::read(r, *target, f))
+                return false;
+        }
+    }
+
+    // Spawns were appended after the kept entities; merge them back into id order.
+    std::inplace_merge(out, out + kept, out + count, [](const T &a, const T &b) {
+        return Fields::id(a) < Fields::id(b);
+    });
+    outCount = static_cast<uint8_t>(count);
+    return true;
+}
+
+constexpr unsigned maxPlayers = maxSnapshotPlayers;
+constexpr unsigned maxEnemies = maxSnapshotEnemies;
+constexpr unsigned maxBullets = maxSnapshotBullets;
+static_assert(maxBullets <= 255 && maxEnemies <= 255, "entity counts are sent as 8 bits");
+
+const GameStatePayload emptySnapshot{};
+
+// Ids are written as gaps from the previous one; two varint bytes is a
+// fair guess without knowing the neighbours.
+constexpr size_t estimatedIdBits = 16;
+
+template<typename Fields>
+size_t deltaBits(const typename Fields::Type &current, const typename Fields::Type* baseline) {
+    char scratch[32];
+    BitWriter w(scratch, sizeof(scratch));
+    for (unsigned f = 0; f < Fields::count; f++) {
+        if (!baseline || !Fields::equal(current, *baseline, f))
+            Fields::write(w, current, f);
+    }
+    size_t fieldBits = w.bitsWritten();
+    if (fieldBits == 0)
+        return 0;
+    return estimatedIdBits + Fields::count + fieldBits;
+}
+
+} // namespace
+
+size_t entityDeltaBits(const GameStatePayload::PlayerState &current, const GameStatePayload::PlayerState* baseline) {
+    return deltaBits<PlayerFields>(current, baseline);
+}
+
+size_t entityDeltaBits(const EnemyState &current, const EnemyState* baseline) {
+    return deltaBits<EnemyFields>(current, baseline);
+}
+
+size_t entityDeltaBits(const BulletState &current, const BulletState* baseline) {
+    return deltaBits<BulletFields>(current, baseline);
+}
+
+void encodeSnapshotDelta(BitWriter &w, const GameStatePayload &baseline, const GameStatePayload &current) {
+    encodeList<PlayerFields>(w, baseline.players, baseline.numPlayers, current.players, current.numPlayers);
+    encodeList<EnemyFields>(w, baseline.enemies, baseline.numEnemies, current.enemies, current.numEnemies);
+    encodeList<BulletFields>(w, baseline.bullets, baseline.numBullets, current.bullets, current.numBullets);
+}
+
+bool decodeSnapshotDelta(BitReader &r, const GameStatePayload &baseline, GameStatePayload &out) {
+    if (baseline.numPlayers > maxPlayers || baseline.numEnemies > maxEnemies ||
+        baseline.numBullets > maxBullets)
+        return false;
+    std::memset(&out, 0, sizeof(GameStatePayload));
+    return decodeList<PlayerFields>(r, baseline.players, baseline.numPlayers, out.players, out.numPlayers, maxPlayers)
+        && decodeList<EnemyFields>(r, baseline.enemies, baseline.numEnemies, out.enemies, out.numEnemies, maxEnemies)
+        && decodeList<BulletFields>(r, baseline.bullets, baseline.numBullets, out.bullets, out.numBullets, maxBullets);
+}
+
+void encodeSnapshot(BitWriter &w, const GameStatePayload &current) {
+    encodeSnapshotDelta(w, emptySnapshot, current);
+}
+
+bool decodeSnapshot(BitReader &r, GameStatePayload &out) {
+    return decodeSnapshotDelta(r, emptySnapshot, out);
+}
+
+namespace {
+
+void writeSnapshotTime(BitWriter &w, const SnapshotTime &time) {
+    w.writeVarUint(time.tick);
+    w.writeBits(time.serverTimeMs, 32);
+}
+
+} // namespace
+
+size_t encodeGameStateBody(uint32_t snapshotSequence, const SnapshotTime &time, const GameStatePayload &gs,
+                           char* out, size_t capacity) {
+    BitWriter w(out, capacity);
+    w.writeVarUint(snapshotSequence);
+    writeSnapshotTime(w, time);
+    encodeSnapshot(w, gs);
+    return w.finish();
+}
+
+size_t encodeGameStateDeltaBody(uint32_t snapshotSequence, uint32_t baselineSequence, const SnapshotTime &time,
+                                const GameStatePayload &baseline, const GameStatePayload &gs,
+                                char* out, size_t capacity) {
+    BitWriter w(out, capacity);
+    w.writeVarUint(snapshotSequence);
+    w.writeVarUint(snapshotSequence - baselineSequence);
+    writeSnapshotTime(w, time);
+    encodeSnapshotDelta(w, baseline, gs);
+    return w.finish();
+}
+
+bool readSnapshotSequence(BitReader &r, uint32_t &snapshotSequence) {
+    return r.readVarUint(snapshotSequence) && snapshotSequence != 0;
+}
+
+bool readDeltaBaseline(BitReader &r, uint32_t snapshotSequence, uint32_t &baselineSequence) {
+    uint32_t gap;
+    if (!r.readVarUint(gap) || gap == 0 || gap > snapshotSequence)
+        return false;
+    baselineSequence = snapshotSequence - gap;
+    return true;
+}
+
+bool readSnapshotTime(BitReader &r, SnapshotTime &time) {
+    return r.readVarUint(time.tick) && r.readBits(time.serverTimeMs, 32);
+}
+
+void quantizeSnapshot(GameStatePayload &gs) {
+    auto snap = [](float v, const QuantRange &range) { return dequantize(quantize(v, range), range); };
+    for (unsigned i = 0; i < gs.numPlayers && i < maxPlayers; i++) {
+        gs.players[i].x = snap(gs.players[i].x, positionRange);
+        gs.players[i].y = snap(gs.players[i].y, positionRange);
+    }
+    for (unsigned i = 0; i < gs.numEnemies && i < maxEnemies; i++) {
+        gs.enemies[i].x = snap(gs.enemies[i].x, positionRange);
+        gs.enemies[i].y = snap(gs.enemies[i].y, positionRange);
+        gs.enemies[i].type &= (1u << enemyTypeBits) - 1;
+    }
+    for (unsigned i = 0; i < gs.numBullets && i < maxBullets; i++) {
+        gs.bullets[i].x = snap(gs.bullets[i].x, positionRange);
+        gs.bullets[i].y = snap(gs.bullets[i].y, positionRange);
+        gs.bullets[i].vx = snap(gs.bullets[i].vx, velocityRange);
+        gs.bullets[i].vy = snap(gs.bullets[i].vy, velocityRange);
+    }
+}
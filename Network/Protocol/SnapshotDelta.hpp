@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_DELTA_HPP
+#define SNAPSHOT_DELTA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "Protocol.hpp"
+#include "BitStream.hpp"
+#include "MessageCodec.hpp"
+
+// Small history of recent snapshots, indexed by their sequence number.
+// The server keeps one to find the baseline a client last acknowledged;
+// the client keeps one to rebuild the same baseline when a delta arrives.
+class SnapshotRing {
+public:
+    static constexpr size_t Size = 32;
+
+    void store(uint32_t sequence, const GameStatePayload &payload);
+    const GameStatePayload* find(uint32_t sequence) const;
+
+private:
+    struct Slot {
+        uint32_t sequence = 0;
+        bool valid = false;
+        GameStatePayload payload{};
+    };
+    Slot slots[Size];
+};
+
+// Writes `current` as the difference from `baseline`: despawned ids, then
+// every new or changed entity with a bitmask of the fields that differ.
+// Fields are compared after quantization, so sub-resolution jitter costs nothing.
+void encodeSnapshotDelta(BitWriter &w, const GameStatePayload &baseline, const GameStatePayload &current);
+
+// Rebuilds the snapshot written by encodeSnapshotDelta. Entities come out
+// sorted by id. Returns false on malformed input.
+bool decodeSnapshotDelta(BitReader &r, const GameStatePayload &baseline, GameStatePayload &out);
+
+// Roughly the bits encodeSnapshotDelta spends on one entity against its
+// baseline state (nullptr for a new entity); 0 when nothing changed at wire
+// precision. Used to pack snapshots under a byte budget.
+size_t entityDeltaBits(const GameStatePayload::PlayerState &current, const GameStatePayload::PlayerState* baseline);
+size_t entityDeltaBits(const EnemyState &current, const EnemyState* baseline);
+size_t entityDeltaBits(const BulletState &current, const BulletState* baseline);
+
+// A full snapshot is a delta against the empty world.
+void encodeSnapshot(BitWriter &w, const GameStatePayload &current);
+bool decodeSnapshot(BitReader &r, GameStatePayload &out);
+
+// When a snapshot was taken: the server's simulation tick, counted from
+// server start, and the server's getCurrentTimeMS() at that tick. Clients
+// relate the latter to their own clock through ClockSync.
+struct SnapshotTime {
+    uint32_t tick = 0;
+    uint32_t serverTimeMs = 0;
+};
+
+// GAME_STATE body: the snapshot's own sequence number, its SnapshotTime,
+// then the full snapshot. Snapshots carry their sequence in the body
+// because packet sequences are per connection and a snapshot may be split
+// across several packets.
+size_t encodeGameStateBody(uint32_t snapshotSequence, const SnapshotTime &time, const GameStatePayload &gs,
+                           char* out, size_t capacity);
+
+// GAME_STATE_DELTA body: the snapshot's sequence, the gap back to the
+// baseline's sequence, its SnapshotTime, then the delta.
+size_t encodeGameStateDeltaBody(uint32_t snapshotSequence, uint32_t baselineSequence, const SnapshotTime &time,
+                                const GameStatePayload &baseline, const GameStatePayload &gs,
+                                char* out, size_t capacity);
+
+bool readSnapshotSequence(BitReader &r, uint32_t &snapshotSequence);
+bool readDeltaBaseline(BitReader &r, uint32_t snapshotSequence, uint32_t &baselineSequence);
+// Follows the sequence (GAME_STATE) or the baseline (GAME_STATE_DELTA).
+bool readSnapshotTime(BitReader &r, SnapshotTime &time);
+
+// Snaps every field to the precision the wire format keeps, i.e. what a
+// client ends up with after decoding.
+void quantizeSnapshot(GameStatePayload &gs);
+
+#endif // SNAPSHOT_DELTA_HPP
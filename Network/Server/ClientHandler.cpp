@@ -2,89 +2,161 @@
 #include "NetworkUtils.hpp"
 #include "Globals.hpp"
 #include "Network/Protocol/Protocol.hpp"
+#include "Network/Protocol/MessageCodec.hpp"
 
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <cstring>
 
-void handleClientMessages(int sock, std::vector<sockaddr_in> &clients, IGame* game) {
-    char buffer[1024];
-    while (true) {
-        sockaddr_in clientAddr;
-        socklen_t addrLen = sizeof(clientAddr);
-        int bytes = recvfrom(sock, buffer, sizeof(buffer), 0,
-                             reinterpret_cast<struct sockaddr*>(&clientAddr), &addrLen);
-        if (bytes < 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
-        }
-        if (bytes < static_cast<int>(sizeof(MessageHeader)))
-            continue;
+namespace {
 
-        MessageHeader inHeader;
-        std::memcpy(&inHeader, buffer, sizeof(MessageHeader));
+// The sender's session if `packet` is new to it, else nullptr. Registers
+// new senders, unless the connection table is full, and feeds the packet's
+// acks to the session.
+ClientSession* receivePacket(const sockaddr_in &clientAddr, const PacketHeader &packet,
+                             ReliableChannel::Clock::time_point now) {
+    bool created = false;
+    ClientSession* session = connections.findOrInsert(clientAddr, created);
+    if (!session)
+        return nullptr;
+    if (created)
+        std::cout << "[Server] New client: " << clientKey(clientAddr) << "\n";
+    session->lastSeen = now;
+    bool fresh = session->channel.receive(packet, now, [&](uint32_t snapshot) {
+        session->onSnapshotPacketAcked(snapshot, now);
+    });
+    return fresh ? session : nullptr;
+}
+
+void markReady(ClientSession &session) {
+    std::cout << "[Server] Client " << clientKey(session.addr) << " is ready.\n";
+    session.ready = true;
+}
 
-        if (inHeader.flags & 1)
-            sendAck(sock, clientAddr, inHeader.sequence);
+bool answerPing(ClientSession &session, PingPayload pp) {
+    pp.serverReceiveTime = getCurrentTimeMS();
+    pp.serverSendTime = getCurrentTimeMS();
+    char pong[maxMessageBody];
+    size_t pongLen = encodeBody(pp, pong, sizeof(pong));
+    // Sent without waiting for the tick so the client's latency
+    // reading does not include our queueing.
+    return queueMessage(session, static_cast<uint8_t>(MessageType::PONG), pong, pongLen) > 0;
+}
 
-        std::string key = clientKey(clientAddr);
-        {
-            std::lock_guard<std::mutex> lock(clientsMutex);
-            bool exists = false;
-            for (const auto &c : clients) {
-                if (c.sin_addr.s_addr == clientAddr.sin_addr.s_addr &&
-                    c.sin_port == clientAddr.sin_port) {
-                    exists = true;
-                    break;
+// Handles one message of a client's datagram. Caller holds clientsMutex.
+// Returns true if a reply was queued that should go out right away.
+bool handleMessage(ClientSession &session, const MessageHeader &h, const char* body, size_t len) {
+    BitReader reader(body, len);
+    switch (h.type) {
+        case static_cast<uint8_t>(MessageType::READY): {
+            markReady(session);
+            break;
+        }
+        case static_cast<uint8_t>(MessageType::PLAYER_INPUT): {
+            PlayerInputBatch batch;
+            if (readPayload(reader, batch)) {
+                uint32_t &lastTick = session.lastInputTick;
+                for (size_t i = batch.count; i-- > 0;) {
+                    const PlayerInputPayload &input = batch.inputs[i];
+                    if (!sequenceNewer(input.tick, lastTick))
+                        continue;
+                    // Never wait on the simulation here; if the tick falls this far
+                    // behind, dropping an input is better than stalling the socket.
+                    inputQueue.tryPush(input);
+                    lastTick = input.tick;
                 }
+                session.hasPlayer = true;
+                session.playerID = batch.inputs[0].netID;
             }
-            if (!exists) {
-                clients.push_back(clientAddr);
-                std::cout << "[Server] New client: " << key << "\n";
-            }
+            break;
         }
+        case static_cast<uint8_t>(MessageType::PING): {
+            PingPayload pp;
+            if (readPayload(reader, pp))
+                return answerPing(session, pp);
+            break;
+        }
+        default:
+            break;
+    }
+    return false;
+}
 
-        switch (inHeader.type) {
-            case static_cast<uint8_t>(MessageType::READY): {
-                std::cout << "[Server] Client " << key << " is ready.\n";
-                {
-                    std::lock_guard<std::mutex> lock(lobbyMutex);
-                    lobbyStatus[key] = true;
-                }
-                break;
-            }
-            case static_cast<uint8_t>(MessageType::PLAYER_INPUT): {
-                if (bytes >= static_cast<int>(sizeof(MessageHeader) + sizeof(PlayerInputPayload))) {
-                    PlayerInputPayload input;
-                    std::memcpy(&input, buffer + sizeof(MessageHeader), sizeof(PlayerInputPayload));
-                    std::lock_guard<std::mutex> lock(pluginMutex);
-                    game->onPlayerInput(input);
-                }
-                break;
-            }
-            case static_cast<uint8_t>(MessageType::PING): {
-                if (bytes >= static_cast<int>(sizeof(MessageHeader) + sizeof(PingPayload))) {
-                    PingPayload pp;
-                    std::memcpy(&pp, buffer + sizeof(MessageHeader), sizeof(PingPayload));
+} // namespace
 
-                    MessageHeader outH;
-                    outH.type = static_cast<uint8_t>(MessageType::PONG);
-                    outH.sequence = 0;
-                    outH.timestamp = getCurrentTimeMS();
-                    outH.flags = 0;
+bool handleDatagram(const sockaddr_in &clientAddr, const char* data, size_t size) {
+    BitReader reader(data, size);
+    PacketHeader packet;
+    if (!readPacketHeader(reader, packet))
+        return false;
 
-                    char outPacket[sizeof(MessageHeader) + sizeof(PingPayload)];
-                    std::memcpy(outPacket, &outH, sizeof(MessageHeader));
-                    std::memcpy(outPacket + sizeof(MessageHeader), &pp, sizeof(PingPayload));
+    auto now = ReliableChannel::Clock::now();
+    ClientSession* fresh = receivePacket(clientAddr, packet, now);
+    if (!fresh)
+        return false;
+    ClientSession &session = *fresh;
 
-                    sendto(sock, outPacket, sizeof(outPacket), 0,
-                           reinterpret_cast<struct sockaddr*>(&clientAddr), sizeof(clientAddr));
-                }
-                break;
-            }
-            default:
-                break;
+    MessageFrameReader frames(data, size, reader.bytesRead());
+    MessageHeader h;
+    const char* body = nullptr;
+    size_t len = 0;
+    bool reply = false;
+    while (frames.next(h, body, len)) {
+        if (h.flags & (messageReliable | messageNeedsAck))
+            session.channel.requestAck(now);
+        if ((h.flags & messageReliable) && !session.channel.acceptReliable(h.reliableID))
+            continue;
+        reply = handleMessage(session, h, body, len) || reply;
+    }
+    if (reply)
+        flushSession(session);
+    return reply;
+}
+
+bool handleReceivedPacket(const ReceivedPacket &packet) {
+    auto now = ReliableChannel::Clock::now();
+    ClientSession* fresh = receivePacket(packet.from, packet.header, now);
+    if (!fresh)
+        return false;
+    ClientSession &session = *fresh;
+
+    if (packet.ackRequested)
+        session.channel.requestAck(now);
+    if (packet.hasPlayer) {
+        session.hasPlayer = true;
+        session.playerID = packet.playerID;
+    }
+    bool ping = packet.hasPing && !packet.pingReliable;
+    for (size_t i = 0; i < packet.reliableCount; i++) {
+        if (!session.channel.acceptReliable(packet.reliableIDs[i]))
+            continue;
+        if (packet.reliableTypes[i] == static_cast<uint8_t>(MessageType::READY))
+            markReady(session);
+        else if (packet.reliableTypes[i] == static_cast<uint8_t>(MessageType::PING))
+            ping = packet.hasPing;
+    }
+    bool reply = ping && answerPing(session, packet.ping);
+    if (reply)
+        flushSession(session);
+    return reply;
+}
+
+void handleClientMessages(int sock) {
+    // Everything already waiting in the socket comes out in one recvmmsg and
+    // is handled under a single lock; replies leave in one sendmmsg.
+    DatagramRing incoming;
+    while (true) {
+        int count = incoming.receive(sock);
+        if (count < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
         }
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        bool reply = false;
+        for (int i = 0; i < count; i++)
+            reply = handleDatagram(incoming.from(i), incoming.data(i), incoming.length(i)) || reply;
+        if (reply)
+            flushDatagrams();
     }
 }
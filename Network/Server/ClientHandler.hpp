@@ -2,9 +2,16 @@
 #define CLIENT_HANDLER_HPP
 
 #include <netinet/in.h>
-#include <vector>
-#include "Game/IGame.hpp"
+#include <cstddef>
+#include "ReceiveShards.hpp"
 
-void handleClientMessages(int sock, std::vector<sockaddr_in> &clients, IGame* game);
+// Registers the sender if new and dispatches every message of one datagram.
+// Caller holds clientsMutex. Returns true if a reply was queued.
+bool handleDatagram(const sockaddr_in &clientAddr, const char* data, size_t size);
+// The same for a datagram a receive shard has decoded, whose inputs it has
+// already queued.
+bool handleReceivedPacket(const ReceivedPacket &packet);
+// Receive thread of the Batched socket backend.
+void handleClientMessages(int sock);
 
 #endif // CLIENT_HANDLER_HPP
@@ -0,0 +1,71 @@
+#include "ClientSession.hpp"
+#include <algorithm>
+
+namespace {
+
+// An unacked snapshot is given up on after this much on top of two round
+// trips, for the ack delay and a little jitter.
+constexpr std::chrono::milliseconds lossSlack{200};
+
+} // namespace
+
+void ClientSession::onSnapshotSent(uint32_t sequence, size_t packets, size_t bytes,
+                                   std::chrono::steady_clock::time_point now) {
+    Delivery &d = deliveries[sequence % SnapshotRing::Size];
+    // A slot still waiting 32 snapshots later was lost long ago.
+    if (d.remaining > 0)
+        rate.onLost(channel.smoothedRttMs(), now);
+    d.sequence = sequence;
+    d.remaining = static_cast<uint8_t>(packets);
+    d.bytes = static_cast<uint32_t>(bytes);
+    d.sentAt = now;
+}
+
+void ClientSession::onSnapshotPacketAcked(uint32_t sequence, std::chrono::steady_clock::time_point now) {
+    Delivery &d = deliveries[sequence % SnapshotRing::Size];
+    if (d.sequence != sequence || d.remaining == 0)
+        return;
+    // A fragmented snapshot only becomes a usable baseline once all of it arrived.
+    if (--d.remaining == 0) {
+        rate.onDelivered(d.bytes, channel.smoothedRttMs(), now);
+        if (sequenceNewer(sequence, ackedSnapshot))
+            ackedSnapshot = sequence;
+    }
+}
+
+void ClientSession::detectLostSnapshots(std::chrono::steady_clock::time_point now) {
+    float srttMs = channel.smoothedRttMs();
+    auto timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float, std::milli>(2.f * srttMs)) + lossSlack;
+    for (Delivery &d : deliveries) {
+        if (d.remaining == 0)
+            continue;
+        // Acks for a packet and the ones just before it arrive in the same
+        // header, so anything older than a fully acked snapshot is not coming.
+        bool overtaken = ackedSnapshot != 0 && sequenceNewer(ackedSnapshot, d.sequence);
+        if (overtaken || now - d.sentAt > timeout) {
+            d.remaining = 0;
+            rate.onLost(srttMs, now);
+        }
+    }
+}
+
+void ClientSession::rememberSnapshot(uint32_t sequence, const GameStatePayload* own) {
+    View &v = views[sequence % SnapshotRing::Size];
+    v.sequence = sequence;
+    v.shared = own == nullptr;
+    if (own) {
+        if (!ownSnapshots)
+            ownSnapshots = std::make_unique<SnapshotRing>();
+        ownSnapshots->store(sequence, *own);
+    }
+}
+
+const GameStatePayload* ClientSession::findSnapshot(uint32_t sequence, const SnapshotRing &history,
+                                                    bool &shared) const {
+    const View &v = views[sequence % SnapshotRing::Size];
+    if (sequence == 0 || v.sequence != sequence)
+        return nullptr;
+    shared = v.shared;
+    return shared ? history.find(sequence) : ownSnapshots->find(sequence);
+}
@@ -0,0 +1,83 @@
+#ifndef CLIENT_SESSION_HPP
+#define CLIENT_SESSION_HPP
+
+#include <netinet/in.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "../Protocol/Reliability.hpp"
+#include "../Protocol/PacketBuilder.hpp"
+#include "../Protocol/SnapshotDelta.hpp"
+#include "PriorityAccumulator.hpp"
+#include "SnapshotRate.hpp"
+
+// Everything the server keeps per connected client. Guarded by clientsMutex.
+struct ClientSession {
+    uint64_t key = 0;        // packAddress(addr)
+    sockaddr_in addr{};
+    // Last time a well-formed datagram arrived; see connectionTimeout.
+    std::chrono::steady_clock::time_point lastSeen;
+    bool ready = false;      // sent READY in the lobby
+
+    ReliableChannel channel;
+    // Messages queued for this client since the last flushSessions().
+    PacketBuilder outgoing;
+
+    // Newest snapshot every packet of which the client acked; the baseline
+    // for its next delta. 0 until one arrives.
+    uint32_t ackedSnapshot = 0;
+
+    // Newest input tick already queued for the game; repeated inputs at or
+    // below it are dropped.
+    uint32_t lastInputTick = 0;
+
+    // The player this client controls, learned from its inputs; interest
+    // management sends everything until then.
+    bool hasPlayer = false;
+    int32_t playerID = 0;
+
+    // Replication priorities and the byte budget they pack snapshots into.
+    PriorityAccumulator priorities;
+    size_t snapshotBudget = defaultSnapshotBudget;
+
+    // Remembers what snapshot `sequence` looked like to this client, for
+    // use as a delta baseline: the shared one kept in the server's history
+    // when `own` is nullptr, else a copy of `own`.
+    void rememberSnapshot(uint32_t sequence, const GameStatePayload* own);
+    // Snapshot `sequence` as this client has it, nullptr once too old.
+    // `shared` tells whether it is the one in `history`.
+    const GameStatePayload* findSnapshot(uint32_t sequence, const SnapshotRing &history, bool &shared) const;
+
+    // Snapshots per second this client gets, from how its snapshots fare.
+    SnapshotRate rate;
+
+    // Called after sending snapshot `sequence`, `bytes` long, as `packets`
+    // tagged packets.
+    void onSnapshotSent(uint32_t sequence, size_t packets, size_t bytes,
+                        std::chrono::steady_clock::time_point now);
+    // Called from channel.receive() for each acked packet tagged with a snapshot.
+    void onSnapshotPacketAcked(uint32_t sequence, std::chrono::steady_clock::time_point now);
+    // Reports to `rate` every snapshot still unacked although a newer one
+    // was fully acked, or for much longer than a round trip.
+    void detectLostSnapshots(std::chrono::steady_clock::time_point now);
+
+private:
+    struct Delivery {
+        uint32_t sequence = 0;
+        uint8_t remaining = 0;
+        uint32_t bytes = 0;
+        std::chrono::steady_clock::time_point sentAt;
+    };
+    Delivery deliveries[SnapshotRing::Size];
+
+    struct View {
+        uint32_t sequence = 0;
+        bool shared = true;
+    };
+    View views[SnapshotRing::Size];
+    // Only allocated once a snapshot differs from the shared one.
+    std::unique_ptr<SnapshotRing> ownSnapshots;
+};
+
+#endif // CLIENT_SESSION_HPP
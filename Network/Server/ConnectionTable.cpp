@@ -0,0 +1,84 @@
+#include "ConnectionTable.hpp"
+#include <utility>
+
+ConnectionTable::ConnectionTable(size_t maxSessions) : m_maxSessions(maxSessions) {
+    size_t slots = 8;
+    while (slots < maxSessions * 2)
+        slots <<= 1;
+    m_slots.resize(slots);
+    m_sessions.reserve(maxSessions);
+}
+
+size_t ConnectionTable::home(uint64_t key) const {
+    // Fibonacci hashing: the multiply mixes the port into the high bits.
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (m_slots.size() - 1);
+}
+
+size_t ConnectionTable::findSlot(uint64_t key) const {
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = home(key);; i = (i + 1) & mask) {
+        if (m_slots[i].key == key)
+            return i;
+        if (m_slots[i].key == EmptyKey)
+            return m_slots.size();
+    }
+}
+
+ClientSession* ConnectionTable::find(uint64_t key) {
+    size_t slot = findSlot(key);
+    return slot == m_slots.size() ? nullptr : &m_sessions[m_slots[slot].index];
+}
+
+ClientSession* ConnectionTable::findOrInsert(const sockaddr_in &addr, bool &created) {
+    uint64_t key = packAddress(addr);
+    created = false;
+    if (ClientSession* existing = find(key))
+        return existing;
+    if (full()) {
+        m_rejected++;
+        return nullptr;
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = home(key);
+    while (m_slots[i].key != EmptyKey)
+        i = (i + 1) & mask;
+    m_slots[i].key = key;
+    m_slots[i].index = static_cast<uint32_t>(m_sessions.size());
+    m_sessions.emplace_back();
+    ClientSession &session = m_sessions.back();
+    session.key = key;
+    session.addr = addr;
+    created = true;
+    return &session;
+}
+
+bool ConnectionTable::erase(uint64_t key) {
+    size_t slot = findSlot(key);
+    if (slot == m_slots.size())
+        return false;
+
+    // Keep the sessions dense: the last one takes the erased one's place.
+    uint32_t index = m_slots[slot].index;
+    uint32_t last = static_cast<uint32_t>(m_sessions.size() - 1);
+    if (index != last) {
+        m_sessions[index] = std::move(m_sessions[last]);
+        m_slots[findSlot(m_sessions[index].key)].index = index;
+    }
+    m_sessions.pop_back();
+
+    // Backward-shift deletion: pull later entries of the probe run into the
+    // hole unless that would move them before their home slot.
+    size_t mask = m_slots.size() - 1;
+    size_t hole = slot;
+    for (size_t i = (hole + 1) & mask; m_slots[i].key != EmptyKey; i = (i + 1) & mask) {
+        size_t h = home(m_slots[i].key);
+        bool movable = (i > hole) ? (h <= hole || h > i) : (h <= hole && h > i);
+        if (movable) {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole] = Slot{};
+    return true;
+}
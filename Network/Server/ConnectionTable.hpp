@@ -0,0 +1,93 @@
+#ifndef CONNECTION_TABLE_HPP
+#define CONNECTION_TABLE_HPP
+
+#include <netinet/in.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ClientSession.hpp"
+
+// Clients silent for this long are dropped. They ping every second, even
+// in the lobby.
+constexpr std::chrono::seconds connectionTimeout{10};
+
+// Sessions the server keeps at once. Datagrams from new addresses are
+// dropped while this many are live, so a flood of spoofed senders cannot
+// grow the table without bound.
+constexpr size_t maxConnections = 64;
+
+// IPv4 address in bits 16..47, port in bits 0..15, both as they are on the
+// wire. Never has the top 16 bits set.
+inline uint64_t packAddress(const sockaddr_in &addr) {
+    return (static_cast<uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+}
+
+// Every connected client's ClientSession, keyed by packAddress(). Sessions
+// are stored densely for the per-tick broadcasts; an open-addressing table
+// with linear probing maps keys to them, so looking up the sender of a
+// datagram neither allocates nor scans. Removal swaps the last session into
+// the hole and shifts later probe entries back, leaving no tombstones.
+//
+// Holds at most maxSessions sessions; the slots are sized for that up
+// front and never rehashed.
+//
+// Sessions move when others are inserted or erased: do not keep pointers
+// across either. Guarded by clientsMutex.
+class ConnectionTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ConnectionTable(size_t maxSessions = maxConnections);
+
+    ClientSession* find(uint64_t key);
+    // The session for `addr`, created if new; `created` tells which.
+    // nullptr if `addr` is new and the table is full.
+    ClientSession* findOrInsert(const sockaddr_in &addr, bool &created);
+    bool erase(uint64_t key);
+
+    size_t size() const { return m_sessions.size(); }
+    bool full() const { return m_sessions.size() >= m_maxSessions; }
+    // New senders turned away because the table was full.
+    uint64_t rejected() const { return m_rejected; }
+    std::vector<ClientSession>::iterator begin() { return m_sessions.begin(); }
+    std::vector<ClientSession>::iterator end() { return m_sessions.end(); }
+
+    // Removes every session not heard from for `timeout`, calling
+    // onEvict(session) just before. Returns how many went.
+    template<typename OnEvict>
+    size_t evictSilent(Clock::time_point now, Clock::duration timeout, OnEvict onEvict);
+
+private:
+    static constexpr uint64_t EmptyKey = ~0ull;
+    struct Slot {
+        uint64_t key = EmptyKey;
+        uint32_t index = 0;
+    };
+
+    size_t home(uint64_t key) const;
+    size_t findSlot(uint64_t key) const;   // m_slots.size() if absent
+
+    std::vector<Slot> m_slots;    // power-of-two size, at most half full
+    std::vector<ClientSession> m_sessions;
+    size_t m_maxSessions;
+    uint64_t m_rejected = 0;
+};
+
+template<typename OnEvict>
+size_t ConnectionTable::evictSilent(Clock::time_point now, Clock::duration timeout, OnEvict onEvict) {
+    size_t evicted = 0;
+    for (size_t i = 0; i < m_sessions.size();) {
+        if (now - m_sessions[i].lastSeen <= timeout) {
+            i++;
+            continue;
+        }
+        onEvict(m_sessions[i]);
+        // Swaps another session into index i, which is checked next.
+        erase(m_sessions[i].key);
+        evicted++;
+    }
+    return evicted;
+}
+
+#endif // CONNECTION_TABLE_HPP
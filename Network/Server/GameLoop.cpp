@@ -1,58 +1,204 @@
 #include "GameLoop.hpp"
 #include "Globals.hpp"
 #include "NetworkUtils.hpp"
+#include "ClientHandler.hpp"
 #include "../Protocol/Protocol.hpp"
+#include "../Protocol/MessageCodec.hpp"
+#include "Engine/Core/TripleBuffer.hpp"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <iostream>
 #include <mutex>
 #include <cstring>
 
-void runGameLoop(int sock, IGame* game, std::vector<sockaddr_in>& clients) {
-    auto lastTime = std::chrono::steady_clock::now();
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr auto tickPeriod = std::chrono::milliseconds(1000 / serverTickRate);
+constexpr auto statsPeriod = std::chrono::seconds(5);
+
+struct PublishedSnapshot {
+    uint32_t sequence = 0;
+    SnapshotTime time;
+    GameStatePayload payload{};
+    AppliedInput applied[maxSnapshotPlayers];
+    size_t appliedCount = 0;
+};
+
+// Simulation thread -> network thread. Written by the simulation without
+// waiting on anything the network thread holds; snapshotReady (an eventfd)
+// only wakes the network thread up.
+Engine::TripleBuffer<PublishedSnapshot> snapshots;
+int snapshotReady = -1;
+
+// Ticks the game at serverTickRate and publishes every resulting state.
+// Never touches sockets or sessions, so encoding and sending the previous
+// snapshot overlaps with simulating the next one.
+void runSimulation(IGame* game) {
+    auto lastTime = Clock::now();
+    auto nextTick = lastTime;
+    uint32_t snapshotSequence = 0;
+    // Counts every tick since the server started, lobby included.
+    uint32_t tick = 0;
+    std::vector<PlayerInputPayload> inputBatch;
+    inputBatch.reserve(inputQueue.capacity());
+    // Per player, the input the game is moving it with.
+    std::vector<AppliedInput> applied;
     while (true) {
-        auto now = std::chrono::steady_clock::now();
+        auto now = Clock::now();
         float dt = std::chrono::duration<float>(now - lastTime).count();
         lastTime = now;
+        tick++;
+
+        inputBatch.clear();
+        inputQueue.drain(inputBatch);
+
+        if (gameStarted.load(std::memory_order_acquire)) {
+            PublishedSnapshot &out = snapshots.back();
+            {
+                std::lock_guard<std::mutex> lock(pluginMutex);
+                game->onPlayerInputs(inputBatch.data(), inputBatch.size());
+                game->onUpdate(dt);
+                out.payload = game->getGameState().payload;
+            }
+            // An input applied this tick has moved its player for this dt already.
+            for (const PlayerInputPayload &input : inputBatch) {
+                auto it = std::find_if(applied.begin(), applied.end(),
+                                       [&](const AppliedInput &a) { return a.playerID == input.netID; });
+                if (it == applied.end())
+                    it = applied.insert(applied.end(), AppliedInput{input.netID, 0, 0.f});
+                it->tick = input.tick;
+                it->heldSeconds = 0.f;
+            }
+            // Players the game no longer has would otherwise keep their
+            // entry, and a slot in out.applied, for good.
+            const GameStatePayload &state = out.payload;
+            applied.erase(std::remove_if(applied.begin(), applied.end(), [&](const AppliedInput &a) {
+                              for (size_t i = 0; i < state.numPlayers; i++) {
+                                  if (state.players[i].playerID == a.playerID)
+                                      return false;
+                              }
+                              return true;
+                          }),
+                          applied.end());
+            out.appliedCount = 0;
+            for (AppliedInput &a : applied) {
+                a.heldSeconds += dt;
+                if (out.appliedCount < maxSnapshotPlayers)
+                    out.applied[out.appliedCount++] = a;
+            }
+            out.sequence = ++snapshotSequence;
+            out.time.tick = tick;
+            out.time.serverTimeMs = getCurrentTimeMS();
+            snapshots.publish();
+            uint64_t one = 1;
+            if (write(snapshotReady, &one, sizeof(one)) < 0) {
+                // Only fails when the counter is saturated; the reader is awake.
+            }
+        }
 
+        nextTick += tickPeriod;
+        // After a stall, tick on from now instead of catching up in a burst.
+        if (nextTick < now)
+            nextTick = now + tickPeriod;
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+// Waits for the next published snapshot, or until `deadline` when none
+// comes (the lobby). With io_uring or receive shards there is no receive
+// thread touching the sessions, so the wait is spent handling datagrams as
+// they arrive.
+void waitForSnapshot(Clock::time_point deadline) {
+    if (UringSocket* uring = serverSocket.uring()) {
+        uring->poll(deadline, [&](const sockaddr_in &from, const char* data, size_t len) {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            handleDatagram(from, data, len);
+        });
+    } else if (receiveShards.count() > 0) {
+        ReceivedPacket packet;
+        while (receiveShards.wait(deadline, snapshotReady)) {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            bool reply = false;
+            while (receiveShards.pop(packet))
+                reply = handleReceivedPacket(packet) || reply;
+            if (reply)
+                flushDatagrams();
+        }
+    } else {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        pollfd pfd{snapshotReady, POLLIN, 0};
+        if (remaining > 0)
+            poll(&pfd, 1, static_cast<int>(remaining));
+    }
+    uint64_t value;
+    if (read(snapshotReady, &value, sizeof(value)) < 0) {
+        // EAGAIN: woken by the deadline, nothing to clear.
+    }
+}
+
+} // namespace
+
+void runGameLoop(IGame* game) {
+    snapshotReady = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (snapshotReady < 0) {
+        std::cerr << "[Server] eventfd failed.\n";
+        return;
+    }
+    if (UringSocket* uring = serverSocket.uring())
+        uring->watch(snapshotReady);
+    std::thread simulation(runSimulation, game);
+
+    // This thread is the send stage: lobby, snapshot encoding and flushing.
+    SnapshotRing history;
+    InterestManager interest(*game);
+    auto nextStats = Clock::now() + statsPeriod;
+    while (true) {
+        auto now = Clock::now();
         {
             std::lock_guard<std::mutex> lock(clientsMutex);
-            std::lock_guard<std::mutex> lock2(lobbyMutex);
-            uint8_t total = static_cast<uint8_t>(clients.size());
+            connections.evictSilent(now, connectionTimeout, [](const ClientSession &session) {
+                std::cout << "[Server] Client " << clientKey(session.addr) << " timed out.\n";
+            });
+            uint8_t total = static_cast<uint8_t>(connections.size());
             uint8_t ready = 0;
-            for (const auto &entry : lobbyStatus) {
-                if (entry.second)
+            for (const ClientSession &session : connections) {
+                if (session.ready)
                     ready++;
             }
-            broadcastLobbyStatus(sock, clients, total, ready);
+            broadcastLobbyStatus(total, ready);
 
-            if (total > 0 && ready == total && !gameStarted) {
+            if (total > 0 && ready == total && !gameStarted.load()) {
                 std::cout << "[Server] All clients ready. Starting game.\n";
                 {
                     std::lock_guard<std::mutex> lock(pluginMutex);
                     game->onStart();
                 }
-                MessageHeader startHeader;
-                startHeader.type      = static_cast<uint8_t>(MessageType::START);
-                startHeader.sequence  = 0;
-                startHeader.timestamp = getCurrentTimeMS();
-                startHeader.flags     = 1; // Mark as important
-                char startPacket[sizeof(MessageHeader)];
-                std::memcpy(startPacket, &startHeader, sizeof(MessageHeader));
-                broadcastPacket(sock, startPacket, sizeof(startPacket), clients);
-                gameStarted = true;
+                broadcastReliable(MessageType::START);
+                gameStarted.store(true, std::memory_order_release);
             }
         }
 
-        if (gameStarted) {
-            std::lock_guard<std::mutex> lock(pluginMutex);
-            game->onUpdate(dt);
-            GameState state = game->getGameState();
-            {
-                std::lock_guard<std::mutex> lock(clientsMutex);
-                broadcastGameState(sock, clients, state.payload);
+        if (snapshots.consume()) {
+            const PublishedSnapshot &snapshot = snapshots.front();
+            history.store(snapshot.sequence, snapshot.payload);
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            broadcastGameState(snapshot.payload, snapshot.sequence, snapshot.time,
+                               snapshot.applied, snapshot.appliedCount, history, interest);
+        }
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            flushSessions();
+            if (reportClientStats && now >= nextStats) {
+                logClientStats();
+                nextStats = now + statsPeriod;
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        waitForSnapshot(Clock::now() + tickPeriod);
     }
+    simulation.join();
 }
@@ -2,9 +2,7 @@
 #define GAME_LOOP_HPP
 
 #include "Game/IGame.hpp"
-#include <vector>
-#include <netinet/in.h>
 
-void runGameLoop(int sock, IGame* game, std::vector<sockaddr_in>& clients);
+void runGameLoop(IGame* game);
 
 #endif // GAME_LOOP_HPP
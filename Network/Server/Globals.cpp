@@ -2,6 +2,10 @@
 
 std::mutex clientsMutex;
 std::mutex pluginMutex;
-std::mutex lobbyMutex;
-std::unordered_map<std::string, bool> lobbyStatus;
-bool gameStarted = false;
+ConnectionTable connections;
+std::atomic<bool> gameStarted{false};
+ServerSocket serverSocket;
+ReceiveShards receiveShards;
+CompressionPolicy compression = defaultCompressionPolicy();
+bool reportClientStats = false;
+Engine::MpscQueue<PlayerInputPayload> inputQueue(4096);
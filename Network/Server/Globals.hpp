@@ -1,16 +1,36 @@
 #ifndef GLOBALS_HPP
 #define GLOBALS_HPP
 
+#include <atomic>
 #include <mutex>
-#include <unordered_map>
-#include <string>
 #include <netinet/in.h>
+#include "Engine/Core/MpscQueue.hpp"
+#include "../Protocol/Protocol.hpp"
+#include "../Protocol/Compression.hpp"
+#include "ConnectionTable.hpp"
+#include "ServerSocket.hpp"
+#include "ReceiveShards.hpp"
 
 extern std::mutex clientsMutex;
 extern std::mutex pluginMutex;
-extern std::mutex lobbyMutex;
 
-extern std::unordered_map<std::string, bool> lobbyStatus;
-extern bool gameStarted;
+// Every client heard from recently. Guarded by clientsMutex.
+extern ConnectionTable connections;
+// Set by the network thread once the lobby is ready; read by the simulation.
+extern std::atomic<bool> gameStarted;
+
+// Datagrams for every client, sent together by flushSessions(). Guarded by
+// clientsMutex.
+extern ServerSocket serverSocket;
+// Only started with --shards; the game loop then owns every session.
+extern ReceiveShards receiveShards;
+
+// Message types queueMessage() compresses; set once at startup.
+extern CompressionPolicy compression;
+// Set by --stats: the game loop logs logClientStats() every few seconds.
+extern bool reportClientStats;
+
+// Filled by the receive thread, drained by the game loop once per tick.
+extern Engine::MpscQueue<PlayerInputPayload> inputQueue;
 
 #endif // GLOBALS_HPP
@@ -0,0 +1,143 @@
+#include "InterestManager.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+template<size_t Words>
+inline void setBit(uint64_t (&bits)[Words], size_t i) {
+    bits[i / 64] |= 1ull << (i % 64);
+}
+
+template<size_t Words>
+inline bool allSet(const uint64_t (&bits)[Words], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!((bits[i / 64] >> (i % 64)) & 1))
+            return false;
+    }
+    return true;
+}
+
+inline int32_t cellOf(float v) {
+    return static_cast<int32_t>(std::floor(v / InterestManager::CellSize));
+}
+
+} // namespace
+
+void SnapshotMask::clear() {
+    std::memset(this, 0, sizeof(*this));
+}
+
+void SnapshotMask::setEverything() {
+    std::memset(this, 0xFF, sizeof(*this));
+    everything = true;
+}
+
+void filterSnapshot(const GameStatePayload &in, const SnapshotMask &mask, GameStatePayload &out) {
+    if (mask.everything) {
+        out = in;
+        return;
+    }
+    out.numPlayers = 0;
+    for (size_t i = 0; i < in.numPlayers; i++) {
+        if (mask.keepsPlayer(i))
+            out.players[out.numPlayers++] = in.players[i];
+    }
+    out.numEnemies = 0;
+    for (size_t i = 0; i < in.numEnemies; i++) {
+        if (mask.keepsEnemy(i))
+            out.enemies[out.numEnemies++] = in.enemies[i];
+    }
+    out.numBullets = 0;
+    for (size_t i = 0; i < in.numBullets; i++) {
+        if (mask.keepsBullet(i))
+            out.bullets[out.numBullets++] = in.bullets[i];
+    }
+}
+
+size_t InterestManager::bucketOf(int32_t cx, int32_t cy) {
+    uint32_t h = static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u;
+    return h % Buckets;
+}
+
+void InterestManager::index(const GameStatePayload &snapshot) {
+    m_snapshot = &snapshot;
+    size_t total = snapshot.numEnemies + snapshot.numBullets;
+    m_entries.resize(total);
+
+    // Counting sort by bucket.
+    size_t counts[Buckets] = {};
+    auto add = [&](EntityKind kind, size_t i, float x, float y, bool place) {
+        size_t b = bucketOf(cellOf(x), cellOf(y));
+        if (place)
+            m_entries[m_start[b] + counts[b]++] = Entry{kind, static_cast<uint8_t>(i), x, y};
+        else
+            counts[b]++;
+    };
+    for (int pass = 0; pass < 2; pass++) {
+        bool place = pass == 1;
+        if (place) {
+            m_start[0] = 0;
+            for (size_t b = 0; b < Buckets; b++)
+                m_start[b + 1] = m_start[b] + counts[b];
+            std::fill(std::begin(counts), std::end(counts), 0);
+        }
+        for (size_t i = 0; i < snapshot.numEnemies; i++)
+            add(EntityKind::Enemy, i, snapshot.enemies[i].x, snapshot.enemies[i].y, place);
+        for (size_t i = 0; i < snapshot.numBullets; i++)
+            add(EntityKind::Bullet, i, snapshot.bullets[i].x, snapshot.bullets[i].y, place);
+    }
+}
+
+bool InterestManager::select(bool hasViewer, int32_t viewerID, SnapshotMask &mask, InterestArea &area) const {
+    if (!m_snapshot || !hasViewer || !m_game.getInterestArea(*m_snapshot, viewerID, area)) {
+        mask.setEverything();
+        return false;
+    }
+    const GameStatePayload &snapshot = *m_snapshot;
+    mask.clear();
+    for (size_t i = 0; i < snapshot.numPlayers; i++)
+        setBit(mask.players, i);
+    for (size_t i = 0; i < snapshot.numBullets; i++) {
+        if (snapshot.bullets[i].ownerID == viewerID)
+            setBit(mask.bullets, i);
+    }
+
+    auto consider = [&](const Entry &e) {
+        float dx = e.x - area.x;
+        float dy = e.y - area.y;
+        if (dx * dx + dy * dy > area.radius * area.radius)
+            return;
+        if (!m_game.isRelevant(snapshot, viewerID, e.kind, e.index))
+            return;
+        if (e.kind == EntityKind::Enemy)
+            setBit(mask.enemies, e.index);
+        else
+            setBit(mask.bullets, e.index);
+    };
+
+    int32_t x0 = cellOf(area.x - area.radius), x1 = cellOf(area.x + area.radius);
+    int32_t y0 = cellOf(area.y - area.radius), y1 = cellOf(area.y + area.radius);
+    // Covering more cells than there are buckets: visit each bucket once.
+    if (static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) >= static_cast<int64_t>(Buckets)) {
+        for (const Entry &e : m_entries)
+            consider(e);
+    } else {
+        // Distinct cells can share a bucket; the distance test drops strays
+        // and setting a bit twice is harmless.
+        for (int32_t cy = y0; cy <= y1; cy++) {
+            for (int32_t cx = x0; cx <= x1; cx++) {
+                size_t b = bucketOf(cx, cy);
+                for (size_t i = m_start[b]; i < m_start[b + 1]; i++)
+                    consider(m_entries[i]);
+            }
+        }
+    }
+    // An area that takes in the whole snapshot, as it does while the arena
+    // fits in view, leaves nothing to filter, so the client shares the one
+    // encoding of the full snapshot.
+    if (allSet(mask.enemies, snapshot.numEnemies) && allSet(mask.bullets, snapshot.numBullets))
+        mask.setEverything();
+    return true;
+}
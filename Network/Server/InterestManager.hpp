@@ -0,0 +1,65 @@
+#ifndef INTEREST_MANAGER_HPP
+#define INTEREST_MANAGER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Game/IGame.hpp"
+#include "../Protocol/Protocol.hpp"
+
+// Which entries of a snapshot's lists one client receives, one bit each.
+struct SnapshotMask {
+    uint64_t players[(maxSnapshotPlayers + 63) / 64];
+    uint64_t enemies[(maxSnapshotEnemies + 63) / 64];
+    uint64_t bullets[(maxSnapshotBullets + 63) / 64];
+    // Set when the mask keeps everything, so the snapshot needs no filtering
+    // and can be encoded once for every such client.
+    bool everything;
+
+    void clear();
+    void setEverything();
+    bool keepsPlayer(size_t i) const { return (players[i / 64] >> (i % 64)) & 1; }
+    bool keepsEnemy(size_t i) const { return (enemies[i / 64] >> (i % 64)) & 1; }
+    bool keepsBullet(size_t i) const { return (bullets[i / 64] >> (i % 64)) & 1; }
+};
+
+// The snapshot a client with `mask` gets: `in` minus the entities the mask
+// drops, order preserved.
+void filterSnapshot(const GameStatePayload &in, const SnapshotMask &mask, GameStatePayload &out);
+
+// Builds each client's relevant set from a uniform grid over the snapshot's
+// enemies and bullets and the game's interest callbacks, so the cost per
+// client follows what is near it rather than the size of the world.
+class InterestManager {
+public:
+    static constexpr float CellSize = 128.f;
+    static constexpr size_t Buckets = 256;
+
+    explicit InterestManager(const IGame &game) : m_game(game) {}
+
+    // Indexes a new snapshot; it must outlive the select() calls for it.
+    void index(const GameStatePayload &snapshot);
+    // Mask of what the client playing `viewerID` receives from the indexed
+    // snapshot, and the area it was built from. Returns false, with every
+    // bit set, when there is no area: the game does not define one or the
+    // client's player is not known yet. `mask.everything` is also set when
+    // the area keeps every entity.
+    bool select(bool hasViewer, int32_t viewerID, SnapshotMask &mask, InterestArea &area) const;
+
+private:
+    struct Entry {
+        EntityKind kind;
+        uint8_t index;
+        float x;
+        float y;
+    };
+    static size_t bucketOf(int32_t cx, int32_t cy);
+
+    const IGame &m_game;
+    const GameStatePayload* m_snapshot = nullptr;
+    // Entries grouped by grid bucket; bucket b is [m_start[b], m_start[b + 1]).
+    std::vector<Entry> m_entries;
+    size_t m_start[Buckets + 1] = {};
+};
+
+#endif // INTEREST_MANAGER_HPP
@@ -1,7 +1,9 @@
 #include "NetworkUtils.hpp"
+#include "Globals.hpp"
 #include <arpa/inet.h>
 #include <cstdio>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
 
 std::string clientKey(const sockaddr_in &c) {
@@ -10,62 +12,203 @@ std::string clientKey(const sockaddr_in &c) {
     return std::string(buf);
 }
 
-void sendAck(int sock, const sockaddr_in &addr, uint32_t seq) {
-    AckPayload ack;
-    ack.ackSequence = seq;
+namespace {
 
-    MessageHeader h;
-    h.type = static_cast<uint8_t>(MessageType::ACK);
-    h.sequence = 0;
-    h.timestamp = getCurrentTimeMS();
-    h.flags = 0;
+struct DatagramSender {
+    const sockaddr_in &addr;
 
-    char packet[sizeof(MessageHeader) + sizeof(AckPayload)];
-    std::memcpy(packet, &h, sizeof(MessageHeader));
-    std::memcpy(packet + sizeof(MessageHeader), &ack, sizeof(AckPayload));
+    // Only copies into serverSocket; the socket sees it on the next
+    // flushDatagrams() or when the backend runs out of room.
+    bool operator()(const char* data, size_t len) const {
+        return serverSocket.queue(addr, data, len);
+    }
+};
 
-    sendto(sock, packet, sizeof(packet), 0,
-           reinterpret_cast<struct sockaddr*>(const_cast<sockaddr_in*>(&addr)), sizeof(addr));
-}
+} // namespace
+
+size_t queueMessage(ClientSession &session, uint8_t type,
+                    const char* body, size_t len, uint8_t flags, uint32_t tag) {
+    DatagramSender send{session.addr};
+    MessageHeader h;
+    h.type = type;
+    h.flags = flags;
+    h.reliableID = 0;
 
-void broadcastPacket(int sock, const char* data, size_t len, const std::vector<sockaddr_in> &clients) {
-    for (const auto &cl : clients) {
-        int sent = sendto(sock, data, static_cast<int>(len), 0,
-                          reinterpret_cast<struct sockaddr*>(const_cast<sockaddr_in*>(&cl)), sizeof(cl));
-        if (sent < 0) {
-            std::cerr << "[Server] broadcastPacket failed.\n";
+    char packed[maxReassembledSize];
+    if (compression.covers(type) && len > 0) {
+        size_t packedLen = compressBody(body, len, packed, sizeof(packed), &snapshotDictionary());
+        if (packedLen && packedLen < len) {
+            body = packed;
+            len = packedLen;
+            h.flags |= messageCompressed;
         }
     }
+
+    if (len <= maxMessageBody)
+        return session.outgoing.add(session.channel, h, body, len, send, tag) ? 1 : 0;
+
+    size_t count = fragmentCount(len);
+    if (count == 0)
+        return 0;
+    h.type = static_cast<uint8_t>(MessageType::FRAGMENT);
+    char fragment[maxMessageBody];
+    for (size_t i = 0; i < count; i++) {
+        size_t fragLen = encodeFragmentBody(tag, type, body, len, i, fragment, sizeof(fragment));
+        if (fragLen == 0 || !session.outgoing.add(session.channel, h, fragment, fragLen, send, tag))
+            return 0;
+    }
+    return count;
+}
+
+void flushSession(ClientSession &session) {
+    DatagramSender send{session.addr};
+    auto now = ReliableChannel::Clock::now();
+    session.channel.flushReliable(now, [&](const MessageHeader &h, const char* body, size_t len) {
+        session.outgoing.add(session.channel, h, body, len, send);
+    });
+    session.outgoing.flush(session.channel, send, session.channel.needsAck(now));
 }
 
-void broadcastLobbyStatus(int sock, const std::vector<sockaddr_in> &clients, uint8_t total, uint8_t ready) {
+void broadcastLobbyStatus(uint8_t total, uint8_t ready) {
     LobbyStatusPayload ls;
     ls.totalClients = total;
     ls.readyClients = ready;
 
-    MessageHeader mh;
-    mh.type = static_cast<uint8_t>(MessageType::LOBBY_STATUS);
-    mh.sequence = 0;
-    mh.timestamp = getCurrentTimeMS();
-    mh.flags = 0;
+    char body[maxPacketSize];
+    size_t len = encodeBody(ls, body, sizeof(body));
+
+    for (ClientSession &session : connections) {
+        if (!queueMessage(session, static_cast<uint8_t>(MessageType::LOBBY_STATUS), body, len)) {
+            std::cerr << "[Server] broadcastLobbyStatus failed.\n";
+        }
+    }
+}
+
+void broadcastGameState(const GameStatePayload &gsPayload, uint32_t sequence, const SnapshotTime &time,
+                        const AppliedInput* applied, size_t appliedCount,
+                        const SnapshotRing &history, InterestManager &interest) {
+    interest.index(gsPayload);
+
+    // Clients that see the whole world share one encoding of the full
+    // snapshot and, since they usually share a baseline, of the delta.
+    char sharedFull[maxReassembledSize];
+    size_t sharedFullLen = 0;
+    char sharedDelta[maxReassembledSize];
+    size_t sharedDeltaLen = 0;
+    uint32_t sharedDeltaBaseline = 0;
+
+    char ownFull[maxReassembledSize];
+    char ownDelta[maxReassembledSize];
+    GameStatePayload current;
+    SnapshotMask mask;
+
+    auto now = std::chrono::steady_clock::now();
+    for (ClientSession &session : connections) {
+        session.detectLostSnapshots(now);
+        if (!session.rate.dueThisTick())
+            continue;
 
-    char packet[sizeof(MessageHeader) + sizeof(LobbyStatusPayload)];
-    std::memcpy(packet, &mh, sizeof(MessageHeader));
-    std::memcpy(packet + sizeof(MessageHeader), &ls, sizeof(LobbyStatusPayload));
+        uint32_t baselineSeq = session.ackedSnapshot;
+        bool baseShared = false;
+        const GameStatePayload* base = session.findSnapshot(baselineSeq, history, baseShared);
 
-    broadcastPacket(sock, packet, sizeof(packet), clients);
+        InterestArea area;
+        bool hasArea = interest.select(session.hasPlayer, session.playerID, mask, area);
+        bool complete = session.priorities.pack(gsPayload, mask, hasArea ? &area : nullptr, session.playerID,
+                                                base, session.snapshotBudget, current);
+        bool shared = complete && mask.everything;
+        session.rememberSnapshot(sequence, shared ? nullptr : &current);
+
+        const char* fullBody;
+        size_t fullLen;
+        const char* deltaBody = nullptr;
+        size_t deltaLen = 0;
+        if (shared && (!base || baseShared)) {
+            if (sharedFullLen == 0)
+                sharedFullLen = encodeGameStateBody(sequence, time, gsPayload, sharedFull, sizeof(sharedFull));
+            fullBody = sharedFull;
+            fullLen = sharedFullLen;
+            if (base) {
+                if (sharedDeltaBaseline != baselineSeq) {
+                    sharedDeltaLen = encodeGameStateDeltaBody(sequence, baselineSeq, time, *base, gsPayload,
+                                                              sharedDelta, sizeof(sharedDelta));
+                    sharedDeltaBaseline = baselineSeq;
+                }
+                deltaBody = sharedDelta;
+                deltaLen = sharedDeltaLen;
+            }
+        } else {
+            fullLen = encodeGameStateBody(sequence, time, current, ownFull, sizeof(ownFull));
+            fullBody = ownFull;
+            if (base) {
+                deltaLen = encodeGameStateDeltaBody(sequence, baselineSeq, time, *base, current,
+                                                    ownDelta, sizeof(ownDelta));
+                deltaBody = ownDelta;
+            }
+        }
+        if (fullLen == 0) {
+            std::cerr << "[Server] Game state exceeds the fragmentation limit.\n";
+            continue;
+        }
+
+        uint8_t type = static_cast<uint8_t>(MessageType::GAME_STATE);
+        const char* body = fullBody;
+        size_t len = fullLen;
+        if (deltaLen && deltaLen < fullLen) {
+            type = static_cast<uint8_t>(MessageType::GAME_STATE_DELTA);
+            body = deltaBody;
+            len = deltaLen;
+        }
+
+        // Queued first so it shares the snapshot's first datagram.
+        for (size_t i = 0; session.hasPlayer && i < appliedCount; i++) {
+            if (applied[i].playerID != session.playerID)
+                continue;
+            InputAckPayload ack;
+            ack.snapshotSequence = sequence;
+            ack.inputTick = applied[i].tick;
+            ack.heldMs = static_cast<uint32_t>(applied[i].heldSeconds * 1000.f + 0.5f);
+            char ackBody[maxMessageBody];
+            size_t ackLen = encodeBody(ack, ackBody, sizeof(ackBody));
+            queueMessage(session, static_cast<uint8_t>(MessageType::INPUT_ACK), ackBody, ackLen);
+        }
+
+        // Snapshots are never resent: the next one supersedes a lost one.
+        size_t packets = queueMessage(session, type, body, len, messageNeedsAck, sequence);
+        if (packets == 0) {
+            std::cerr << "[Server] broadcastGameState failed.\n";
+            continue;
+        }
+        session.onSnapshotSent(sequence, packets, len, now);
+    }
+}
+
+void broadcastReliable(MessageType type) {
+    for (ClientSession &session : connections) {
+        if (!session.channel.sendReliable(static_cast<uint8_t>(type), nullptr, 0)) {
+            std::cerr << "[Server] Reliable queue full for " << clientKey(session.addr) << ".\n";
+        }
+    }
 }
 
-void broadcastGameState(int sock, const std::vector<sockaddr_in> &clients, const GameStatePayload &gsPayload) {
-    MessageHeader mh;
-    mh.type = static_cast<uint8_t>(MessageType::GAME_STATE);
-    mh.sequence = 0;
-    mh.timestamp = getCurrentTimeMS();
-    mh.flags = 1;
+void flushSessions() {
+    for (ClientSession &session : connections)
+        flushSession(session);
+    flushDatagrams();
+}
 
-    char packet[sizeof(MessageHeader) + sizeof(GameStatePayload)];
-    std::memcpy(packet, &mh, sizeof(MessageHeader));
-    std::memcpy(packet + sizeof(MessageHeader), &gsPayload, sizeof(GameStatePayload));
+void flushDatagrams() {
+    serverSocket.flush();
+}
 
-    broadcastPacket(sock, packet, sizeof(packet), clients);
+void logClientStats() {
+    for (const ClientSession &session : connections) {
+        std::cout << "[Server] " << clientKey(session.addr) << std::fixed << std::setprecision(1)
+                  << " snapshots " << session.rate.rate() << "/s"
+                  << ", bandwidth " << (session.rate.bandwidth() / 1024.f) << " KiB/s"
+                  << ", loss " << (session.rate.lossRate() * 100.f) << "%"
+                  << ", rtt " << session.channel.smoothedRttMs() << " ms\n";
+    }
+    if (connections.rejected())
+        std::cout << "[Server] " << connections.rejected() << " datagrams from new clients dropped, table full\n";
 }
@@ -2,15 +2,54 @@
 #define NETWORK_UTILS_HPP
 
 #include <netinet/in.h>
-#include <vector>
 #include <cstdint>
 #include <string>
 #include "../Protocol/Protocol.hpp"
+#include "../Protocol/SnapshotDelta.hpp"
+#include "../Protocol/Fragmentation.hpp"
+#include "ClientSession.hpp"
+#include "InterestManager.hpp"
 
+// "ip:port", for logs only; lookups use packAddress().
 std::string clientKey(const sockaddr_in &c);
-void sendAck(int sock, const sockaddr_in &addr, uint32_t seq);
-void broadcastPacket(int sock, const char* data, size_t len, const std::vector<sockaddr_in> &clients);
-void broadcastLobbyStatus(int sock, const std::vector<sockaddr_in> &clients, uint8_t total, uint8_t ready);
-void broadcastGameState(int sock, const std::vector<sockaddr_in> &clients, const GameStatePayload &gsPayload);
+// Queues one message for `session`, compressed if `compression` covers its
+// type and that helps, and split into FRAGMENT messages when it does not
+// fit in a datagram. Full datagrams move to serverSocket; the rest waits
+// for flushSession(). Every packet carrying it is tagged with `tag`.
+// Returns the number of packets it occupies, 0 on failure.
+size_t queueMessage(ClientSession &session, uint8_t type,
+                    const char* body, size_t len, uint8_t flags = 0, uint32_t tag = 0);
+// Packs what is queued for one client, plus due reliable resends and a bare
+// ack if a receipt has waited too long for one, into serverSocket.
+void flushSession(ClientSession &session);
+void broadcastLobbyStatus(uint8_t total, uint8_t ready);
+// The newest input of one player the simulation had applied when a
+// snapshot was taken, and for how long it had been applied since.
+struct AppliedInput {
+    int32_t playerID = 0;
+    uint32_t tick = 0;
+    float heldSeconds = 0.f;
+};
+
+// Queues for each client due a snapshot at its current rate the part of the
+// snapshot `interest` finds relevant to it, packed by priority into the
+// client's byte budget, as a delta
+// against the last snapshot it fully acknowledged, or in full when that
+// baseline is unknown or too old. A client whose player is in `applied`
+// gets an INPUT_ACK for it just ahead of the snapshot.
+void broadcastGameState(const GameStatePayload &gsPayload, uint32_t sequence, const SnapshotTime &time,
+                        const AppliedInput* applied, size_t appliedCount,
+                        const SnapshotRing &history, InterestManager &interest);
+// Queues a reliable header-only message for every client.
+void broadcastReliable(MessageType type);
+// flushSession() for every client, then one flushDatagrams(); called once
+// per tick.
+void flushSessions();
+// Sends everything queued in serverSocket. Caller holds clientsMutex.
+void flushDatagrams();
+// One line per client: snapshot rate, acknowledged snapshot bandwidth,
+// loss and RTT, then how many datagrams from new senders the full table
+// turned away. Caller holds clientsMutex.
+void logClientStats();
 
 #endif // NETWORK_UTILS_HPP
@@ -0,0 +1,135 @@
+#include "PriorityAccumulator.hpp"
+#include "../Protocol/SnapshotDelta.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Per-list counts in the delta, despawn and change lists for each kind.
+constexpr size_t listOverheadBits = 6 * 8;
+
+inline uint64_t keyOf(EntityKind kind, int32_t id) {
+    return (static_cast<uint64_t>(kind) << 32) | static_cast<uint32_t>(id);
+}
+
+} // namespace
+
+float PriorityAccumulator::previous(uint64_t key) const {
+    auto it = std::lower_bound(m_priorities.begin(), m_priorities.end(), key,
+                               [](const Priority &p, uint64_t k) { return p.key < k; });
+    return (it != m_priorities.end() && it->key == key) ? it->value : 0.f;
+}
+
+bool PriorityAccumulator::pack(const GameStatePayload &snapshot, const SnapshotMask &mask, const InterestArea* area,
+                               int32_t viewerID, const GameStatePayload* baseline, size_t budget,
+                               GameStatePayload &out) {
+    long remaining = static_cast<long>(budget * 8) - static_cast<long>(listOverheadBits);
+
+    out.numPlayers = 0;
+    for (size_t i = 0; i < snapshot.numPlayers; i++) {
+        if (!mask.keepsPlayer(i))
+            continue;
+        const auto &p = snapshot.players[i];
+        const GameStatePayload::PlayerState* base = nullptr;
+        for (size_t b = 0; baseline && b < baseline->numPlayers; b++) {
+            if (baseline->players[b].playerID == p.playerID)
+                base = &baseline->players[b];
+        }
+        remaining -= static_cast<long>(entityDeltaBits(p, base));
+        out.players[out.numPlayers++] = p;
+    }
+
+    auto indexBaseline = [](std::vector<BaseEntry> &entries, auto idOf, size_t count) {
+        entries.clear();
+        for (size_t i = 0; i < count; i++)
+            entries.push_back(BaseEntry{idOf(i), static_cast<uint8_t>(i)});
+        std::sort(entries.begin(), entries.end(), [](const BaseEntry &a, const BaseEntry &b) { return a.id < b.id; });
+    };
+    auto findBaseline = [](const std::vector<BaseEntry> &entries, int32_t id) -> int16_t {
+        auto it = std::lower_bound(entries.begin(), entries.end(), id,
+                                   [](const BaseEntry &e, int32_t k) { return e.id < k; });
+        return (it != entries.end() && it->id == id) ? it->index : -1;
+    };
+    indexBaseline(m_baseEnemies, [&](size_t i) { return baseline->enemies[i].enemyID; },
+                  baseline ? baseline->numEnemies : 0);
+    indexBaseline(m_baseBullets, [&](size_t i) { return baseline->bullets[i].bulletID; },
+                  baseline ? baseline->numBullets : 0);
+
+    auto falloff = [&](float x, float y) {
+        if (!area)
+            return 1.f;
+        float distance = std::hypot(x - area->x, y - area->y);
+        return 1.f / (1.f + distance / FalloffDistance);
+    };
+
+    // Unchanged entities cost nothing and go as they are; the rest compete.
+    out.numEnemies = 0;
+    out.numBullets = 0;
+    m_candidates.clear();
+    for (size_t i = 0; i < snapshot.numEnemies; i++) {
+        if (!mask.keepsEnemy(i))
+            continue;
+        const EnemyState &e = snapshot.enemies[i];
+        int16_t b = findBaseline(m_baseEnemies, e.enemyID);
+        size_t bits = entityDeltaBits(e, b >= 0 ? &baseline->enemies[b] : nullptr);
+        if (bits == 0) {
+            out.enemies[out.numEnemies++] = e;
+            continue;
+        }
+        uint64_t key = keyOf(EntityKind::Enemy, e.enemyID);
+        float priority = previous(key) + EnemyWeight * falloff(e.x, e.y);
+        m_candidates.push_back(Candidate{key, priority, static_cast<uint32_t>(bits), EntityKind::Enemy,
+                                         static_cast<uint8_t>(i), b});
+    }
+    for (size_t i = 0; i < snapshot.numBullets; i++) {
+        if (!mask.keepsBullet(i))
+            continue;
+        const BulletState &bullet = snapshot.bullets[i];
+        int16_t b = findBaseline(m_baseBullets, bullet.bulletID);
+        size_t bits = entityDeltaBits(bullet, b >= 0 ? &baseline->bullets[b] : nullptr);
+        if (bits == 0) {
+            out.bullets[out.numBullets++] = bullet;
+            continue;
+        }
+        uint64_t key = keyOf(EntityKind::Bullet, bullet.bulletID);
+        float weight = bullet.ownerID == viewerID ? OwnBulletWeight : BulletWeight;
+        float priority = previous(key) + weight * falloff(bullet.x, bullet.y);
+        m_candidates.push_back(Candidate{key, priority, static_cast<uint32_t>(bits), EntityKind::Bullet,
+                                         static_cast<uint8_t>(i), b});
+    }
+
+    std::sort(m_candidates.begin(), m_candidates.end(),
+              [](const Candidate &a, const Candidate &b) { return a.priority > b.priority; });
+
+    m_next.clear();
+    bool heldBack = false;
+    bool sentAny = false;
+    for (const Candidate &c : m_candidates) {
+        // The top entity always goes, so a budget smaller than one update
+        // still makes progress. Smaller updates further down may still fit.
+        bool send = !sentAny || static_cast<long>(c.bits) <= remaining;
+        if (send) {
+            remaining -= static_cast<long>(c.bits);
+            sentAny = true;
+        } else {
+            heldBack = true;
+            m_next.push_back(Priority{c.key, c.priority});
+        }
+        if (c.kind == EntityKind::Enemy) {
+            if (send)
+                out.enemies[out.numEnemies++] = snapshot.enemies[c.index];
+            else if (c.baseIndex >= 0)
+                out.enemies[out.numEnemies++] = baseline->enemies[c.baseIndex];
+        } else {
+            if (send)
+                out.bullets[out.numBullets++] = snapshot.bullets[c.index];
+            else if (c.baseIndex >= 0)
+                out.bullets[out.numBullets++] = baseline->bullets[c.baseIndex];
+        }
+    }
+
+    // Entities sent or gone start from zero next time.
+    std::sort(m_next.begin(), m_next.end(), [](const Priority &a, const Priority &b) { return a.key < b.key; });
+    m_priorities.swap(m_next);
+    return !heldBack;
+}
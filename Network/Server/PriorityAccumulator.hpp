@@ -0,0 +1,66 @@
+#ifndef PRIORITY_ACCUMULATOR_HPP
+#define PRIORITY_ACCUMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Game/IGame.hpp"
+#include "../Protocol/Protocol.hpp"
+#include "InterestManager.hpp"
+
+// Bytes of entity updates one client gets per snapshot. One datagram's
+// worth, so a snapshot at budget is never fragmented.
+constexpr size_t defaultSnapshotBudget = 1024;
+
+// Per-client replication priority for enemies and bullets. Each tick an
+// entity the client should see is not sent, its priority grows by a weight
+// for its kind, falling off with distance from the client's interest area;
+// sending it resets it. Snapshots are packed in priority order until the
+// budget runs out, so under pressure bandwidth rotates across entities
+// instead of starving the same ones every tick.
+class PriorityAccumulator {
+public:
+    static constexpr float EnemyWeight = 1.f;
+    static constexpr float BulletWeight = 1.5f;
+    static constexpr float OwnBulletWeight = 2.f;
+    // Distance at which an entity's weight has halved.
+    static constexpr float FalloffDistance = 256.f;
+
+    // Builds in `out` the snapshot `viewerID` gets from `snapshot`: the
+    // entities `mask` keeps, with the changes that fit in `budget` bytes.
+    // Players are always sent. An entity held back keeps its state from
+    // `baseline` (the snapshot the client acknowledged, nullptr if none), so
+    // the delta costs nothing for it, or is left out if it is new.
+    // Returns true when nothing was held back.
+    bool pack(const GameStatePayload &snapshot, const SnapshotMask &mask, const InterestArea* area,
+              int32_t viewerID, const GameStatePayload* baseline, size_t budget, GameStatePayload &out);
+
+private:
+    struct Priority {
+        uint64_t key;       // kind in the high word, id in the low one
+        float value;
+    };
+    struct Candidate {
+        uint64_t key;
+        float priority;
+        uint32_t bits;
+        EntityKind kind;
+        uint8_t index;
+        int16_t baseIndex;  // -1 when new to the client
+    };
+    struct BaseEntry {
+        int32_t id;
+        uint8_t index;
+    };
+
+    float previous(uint64_t key) const;
+
+    // Sorted by key; rebuilt every pack() with only the entities held back.
+    std::vector<Priority> m_priorities;
+    std::vector<Priority> m_next;
+    std::vector<Candidate> m_candidates;
+    std::vector<BaseEntry> m_baseEnemies;
+    std::vector<BaseEntry> m_baseBullets;
+};
+
+#endif // PRIORITY_ACCUMULATOR_HPP
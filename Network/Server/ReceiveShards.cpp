@@ -0,0 +1,202 @@
+#include "ReceiveShards.hpp"
+#include "ConnectionTable.hpp"
+#include "../Protocol/DatagramRing.hpp"
+#include "../Protocol/MessageCodec.hpp"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+// Decodes one client datagram into `out` and the newest input batch in it.
+// False if it does not decode.
+bool decodePacket(const char* data, size_t len, ReceivedPacket &out, PlayerInputBatch &input, bool &hasInput) {
+    BitReader reader(data, len);
+    if (!readPacketHeader(reader, out.header))
+        return false;
+    out.ackRequested = false;
+    out.hasPlayer = false;
+    out.hasPing = false;
+    out.pingReliable = false;
+    out.reliableCount = 0;
+    hasInput = false;
+
+    MessageFrameReader frames(data, len, reader.bytesRead());
+    MessageHeader h;
+    const char* body = nullptr;
+    size_t bodyLen = 0;
+    while (frames.next(h, body, bodyLen)) {
+        if (h.flags & (messageReliable | messageNeedsAck))
+            out.ackRequested = true;
+        bool reliable = (h.flags & messageReliable) != 0;
+        if (reliable) {
+            // More than a peer's ReliableChannel ever packs into one packet.
+            if (out.reliableCount == ReceivedPacket::MaxReliable)
+                return false;
+            out.reliableIDs[out.reliableCount] = h.reliableID;
+            out.reliableTypes[out.reliableCount] = h.type;
+            out.reliableCount++;
+        }
+        BitReader payload(body, bodyLen);
+        if (h.type == static_cast<uint8_t>(MessageType::PLAYER_INPUT)) {
+            // Batches repeat the previous inputs; the newest covers the rest.
+            if (readPayload(payload, input))
+                hasInput = true;
+        } else if (h.type == static_cast<uint8_t>(MessageType::PING)) {
+            if (readPayload(payload, out.ping)) {
+                out.hasPing = true;
+                out.pingReliable = reliable;
+            }
+        }
+    }
+    if (hasInput) {
+        out.hasPlayer = true;
+        out.playerID = input.inputs[0].netID;
+    }
+    return true;
+}
+
+// Per client, the newest input tick a shard has queued. Forgotten when the
+// client has been silent as long as it takes the game loop to drop its
+// session, so a reconnecting client starts over in both.
+struct ShardClient {
+    uint32_t lastInputTick = 0;
+    ReceiveShards::Clock::time_point lastSeen;
+};
+
+} // namespace
+
+ReceiveShards::~ReceiveShards() {
+    stop();
+}
+
+bool ReceiveShards::start(int sock, size_t count, Engine::MpscQueue<PlayerInputPayload> &inputs) {
+    sockaddr_in local;
+    socklen_t localLen = sizeof(local);
+    if (count == 0 || getsockname(sock, reinterpret_cast<sockaddr*>(&local), &localLen) < 0)
+        return false;
+    m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup < 0)
+        return false;
+    m_queue.reset(new Engine::MpscQueue<ReceivedPacket>(QueueCapacity));
+    m_inputs = &inputs;
+
+    m_receiving.push_back(sock);
+    for (size_t i = 1; i < count; i++) {
+        int shard = socket(AF_INET, SOCK_DGRAM, 0);
+        int one = 1;
+        if (shard < 0 || setsockopt(shard, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0 ||
+            bind(shard, reinterpret_cast<sockaddr*>(&local), localLen) < 0) {
+            std::cerr << "[Server] Could not open receive shard " << i << ".\n";
+            if (shard >= 0)
+                close(shard);
+            break;
+        }
+        m_sockets.push_back(shard);
+        m_receiving.push_back(shard);
+    }
+    for (int s : m_receiving)
+        m_threads.emplace_back(&ReceiveShards::receiveLoop, this, s);
+    std::cout << "[Server] " << m_threads.size() << " receive shards.\n";
+    return true;
+}
+
+void ReceiveShards::stop() {
+    m_stopping.store(true);
+    // Wakes threads blocked in recvmmsg; they see m_stopping and return.
+    for (int s : m_receiving)
+        shutdown(s, SHUT_RD);
+    for (auto &t : m_threads) {
+        if (t.joinable())
+            t.join();
+    }
+    m_threads.clear();
+    m_receiving.clear();
+    for (int s : m_sockets)
+        close(s);
+    m_sockets.clear();
+    if (m_wakeup >= 0)
+        close(m_wakeup);
+    m_wakeup = -1;
+}
+
+void ReceiveShards::receiveLoop(int sock) {
+    DatagramRing incoming;
+    ReceivedPacket routed;
+    PlayerInputBatch batch;
+    std::unordered_map<uint64_t, ShardClient> clients;
+    auto nextSweep = Clock::now() + connectionTimeout;
+    while (!m_stopping.load(std::memory_order_relaxed)) {
+        int count = incoming.receive(sock);
+        if (count <= 0)
+            continue;
+        auto now = Clock::now();
+        if (now >= nextSweep) {
+            for (auto it = clients.begin(); it != clients.end();)
+                it = now - it->second.lastSeen > connectionTimeout ? clients.erase(it) : std::next(it);
+            nextSweep = now + connectionTimeout;
+        }
+        bool any = false;
+        for (int i = 0; i < count; i++) {
+            bool hasInput = false;
+            if (!decodePacket(incoming.data(i), incoming.length(i), routed, batch, hasInput))
+                continue;
+            routed.from = incoming.from(i);
+
+            // Capped like the game loop's table, which would drop a new
+            // sender's packets anyway once full.
+            uint64_t key = packAddress(routed.from);
+            auto found = clients.find(key);
+            if (found == clients.end()) {
+                if (clients.size() >= maxConnections)
+                    continue;
+                found = clients.emplace(key, ShardClient{}).first;
+            }
+            ShardClient &client = found->second;
+            if (now - client.lastSeen > connectionTimeout)
+                client.lastInputTick = 0;
+            client.lastSeen = now;
+            // Oldest first, so the simulation sees them in order. Never
+            // wait on it: dropping an input beats stalling the socket.
+            for (size_t j = hasInput ? batch.count : 0; j-- > 0;) {
+                const PlayerInputPayload &input = batch.inputs[j];
+                if (!sequenceNewer(input.tick, client.lastInputTick))
+                    continue;
+                m_inputs->tryPush(input);
+                client.lastInputTick = input.tick;
+            }
+
+            if (m_queue->tryPush(routed))
+                any = true;
+            else
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (any) {
+            uint64_t one = 1;
+            if (write(m_wakeup, &one, sizeof(one)) < 0) {
+                // EAGAIN only: the counter is saturated, the consumer is awake anyway.
+            }
+        }
+    }
+}
+
+bool ReceiveShards::wait(Clock::time_point deadline, int wakeFd) {
+    auto now = Clock::now();
+    if (now >= deadline)
+        return false;
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+    pollfd pfds[2] = {{m_wakeup, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    // Rounded up so a sub-millisecond remainder does not spin.
+    if (poll(pfds, wakeFd >= 0 ? 2 : 1, static_cast<int>(remaining) + 1) <= 0)
+        return true;
+    if (pfds[0].revents & POLLIN) {
+        uint64_t value;
+        if (read(m_wakeup, &value, sizeof(value)) < 0) {
+            // Nothing to clear; a spurious wake-up is harmless.
+        }
+    }
+    return !(pfds[1].revents & POLLIN);
+}
@@ -0,0 +1,89 @@
+#ifndef RECEIVE_SHARDS_HPP
+#define RECEIVE_SHARDS_HPP
+
+#include <netinet/in.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Engine/Core/MpscQueue.hpp"
+#include "../Protocol/Protocol.hpp"
+#include "../Protocol/Reliability.hpp"
+
+// What is left of one client datagram once a shard has decoded it: the
+// packet header, which feeds the session's acks, and the messages that need
+// session state. Its inputs are not in it; the shard queues those for the
+// simulation itself.
+struct ReceivedPacket {
+    static constexpr size_t MaxReliable = ReliableChannel::MaxReliablePerPacket;
+
+    sockaddr_in from;
+    PacketHeader header;
+    // Some message was reliable or asked for an ack.
+    bool ackRequested;
+    // The player the client's inputs are for, if it sent any.
+    bool hasPlayer;
+    int32_t playerID;
+    // The last PING in the packet; a reliable one is only answered if
+    // acceptReliable() takes it.
+    bool hasPing;
+    bool pingReliable;
+    PingPayload ping;
+    uint8_t reliableCount;
+    uint32_t reliableIDs[MaxReliable];
+    uint8_t reliableTypes[MaxReliable];
+};
+
+// Several SO_REUSEPORT sockets on the server port, each read by its own
+// thread, so the kernel spreads clients across cores by hashing their
+// address. Shards batch-receive and decode every datagram. Inputs go
+// straight to the simulation's input queue: the kernel keeps a client on
+// one shard, so the shard can drop repeated inputs itself. The rest of each
+// packet is routed to the thread that owns the sessions as a
+// ReceivedPacket through one lock-free queue, and that thread is woken
+// through an eventfd. Datagrams that do not decode are dropped.
+class ReceiveShards {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t QueueCapacity = 8192;
+
+    ReceiveShards() = default;
+    ReceiveShards(const ReceiveShards &) = delete;
+    ReceiveShards &operator=(const ReceiveShards &) = delete;
+    ~ReceiveShards();
+
+    // `sock` must be bound with SO_REUSEPORT; count - 1 more sockets are
+    // bound to the same address. Starts one receive thread per socket, each
+    // pushing the inputs it decodes into `inputs`.
+    bool start(int sock, size_t count, Engine::MpscQueue<PlayerInputPayload> &inputs);
+    // Stops the receive threads and closes the sockets start() opened.
+    void stop();
+    size_t count() const { return m_threads.size(); }
+
+    // Consumer side. Blocks until something was routed or `deadline`
+    // passes; false once it has, or as soon as `wakeFd` is readable.
+    // Reading `wakeFd` is up to the caller.
+    bool wait(Clock::time_point deadline, int wakeFd = -1);
+    bool pop(ReceivedPacket &out) { return m_queue->tryPop(out); }
+
+    // Datagrams dropped because the tick thread fell this far behind.
+    uint64_t droppedDatagrams() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void receiveLoop(int sock);
+
+    std::unique_ptr<Engine::MpscQueue<ReceivedPacket>> m_queue;
+    Engine::MpscQueue<PlayerInputPayload>* m_inputs = nullptr;
+    int m_wakeup = -1;
+    std::vector<int> m_sockets;    // all but the caller's
+    std::vector<int> m_receiving;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+#endif // RECEIVE_SHARDS_HPP
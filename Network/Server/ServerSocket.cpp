@@ -0,0 +1,35 @@
+#include "ServerSocket.hpp"
+#include <iostream>
+
+const char* socketBackendName(SocketBackend backend) {
+    return backend == SocketBackend::IoUring ? "io_uring" : "recvmmsg/sendmmsg";
+}
+
+SocketBackend ServerSocket::open(int sock, SocketBackend wanted) {
+    m_sock = sock;
+    m_backend = SocketBackend::Batched;
+    if (wanted == SocketBackend::IoUring) {
+        m_uring.reset(new UringSocket());
+        if (m_uring->open(sock)) {
+            m_backend = SocketBackend::IoUring;
+        } else {
+            std::cerr << "[Server] io_uring unavailable, falling back to "
+                      << socketBackendName(m_backend) << ".\n";
+            m_uring.reset();
+        }
+    }
+    std::cout << "[Server] Socket backend: " << socketBackendName(m_backend) << "\n";
+    return m_backend;
+}
+
+bool ServerSocket::queue(const sockaddr_in &to, const char* data, size_t len) {
+    if (m_uring)
+        return m_uring->queue(to, data, len);
+    return m_outgoing.queue(m_sock, to, data, len);
+}
+
+bool ServerSocket::flush() {
+    if (m_uring)
+        return m_uring->flush();
+    return m_outgoing.flush(m_sock);
+}
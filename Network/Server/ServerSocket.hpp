@@ -0,0 +1,37 @@
+#ifndef SERVER_SOCKET_HPP
+#define SERVER_SOCKET_HPP
+
+#include <netinet/in.h>
+#include <cstddef>
+#include <memory>
+#include "../Protocol/DatagramRing.hpp"
+#include "UringSocket.hpp"
+
+enum class SocketBackend {
+    Batched,    // receive thread on recvmmsg, sendmmsg once per tick
+    IoUring     // no receive thread; the game loop reaps completions
+};
+
+const char* socketBackendName(SocketBackend backend);
+
+// Outgoing side of the server's UDP socket, whichever backend is in use.
+class ServerSocket {
+public:
+    // Takes over a bound socket. Falls back to Batched when io_uring is
+    // wanted but cannot be set up; returns the backend actually used.
+    SocketBackend open(int sock, SocketBackend wanted);
+    SocketBackend backend() const { return m_backend; }
+    // Only set for the IoUring backend.
+    UringSocket* uring() { return m_uring.get(); }
+
+    bool queue(const sockaddr_in &to, const char* data, size_t len);
+    bool flush();
+
+private:
+    int m_sock = -1;
+    SocketBackend m_backend = SocketBackend::Batched;
+    DatagramRing m_outgoing;
+    std::unique_ptr<UringSocket> m_uring;
+};
+
+#endif // SERVER_SOCKET_HPP
@@ -0,0 +1,60 @@
+#include "SnapshotRate.hpp"
+#include <algorithm>
+
+namespace {
+
+// Weight of the newest snapshot in the smoothed loss rate.
+constexpr float lossGain = 0.05f;
+constexpr std::chrono::seconds bandwidthWindow{1};
+constexpr std::chrono::milliseconds minDecreaseInterval{100};
+
+} // namespace
+
+bool SnapshotRate::dueThisTick() {
+    // Capped so a rate increase never releases a burst of saved-up ticks.
+    m_credit = std::min(m_credit + m_rate / MaxRate, 1.f);
+    if (m_credit < 1.f)
+        return false;
+    m_credit -= 1.f;
+    return true;
+}
+
+void SnapshotRate::onDelivered(size_t bytes, float srttMs, Clock::time_point now) {
+    m_loss *= 1.f - lossGain;
+
+    if (m_windowStart == Clock::time_point{})
+        m_windowStart = now;
+    m_windowBytes += bytes;
+    auto elapsed = now - m_windowStart;
+    if (elapsed >= bandwidthWindow) {
+        m_bandwidth = static_cast<float>(m_windowBytes) / std::chrono::duration<float>(elapsed).count();
+        m_windowBytes = 0;
+        m_windowStart = now;
+    }
+
+    if (srttMs > 0.f && (m_minRttMs == 0.f || srttMs < m_minRttMs))
+        m_minRttMs = srttMs;
+    if (srttMs - m_minRttMs > DelayThresholdMs) {
+        decrease(srttMs, now);
+        return;
+    }
+    // +Increase per second: about m_rate deliveries a second, each adding
+    // Increase / m_rate.
+    m_rate = std::min(MaxRate, m_rate + Increase / m_rate);
+}
+
+void SnapshotRate::onLost(float srttMs, Clock::time_point now) {
+    m_loss = m_loss * (1.f - lossGain) + lossGain;
+    decrease(srttMs, now);
+}
+
+void SnapshotRate::decrease(float srttMs, Clock::time_point now) {
+    // One loss event per round trip: the snapshots already in flight when
+    // the first was lost say nothing new about the lower rate.
+    auto interval = std::max<Clock::duration>(
+        minDecreaseInterval, std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(srttMs)));
+    if (now - m_lastDecrease < interval)
+        return;
+    m_lastDecrease = now;
+    m_rate = std::max(MinRate, m_rate * Decrease);
+}
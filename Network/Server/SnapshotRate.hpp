@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_RATE_HPP
+#define SNAPSHOT_RATE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include "../Protocol/Protocol.hpp"
+
+// How many snapshots per second one client gets, adjusted AIMD-style from
+// how its snapshots fare: every delivered one raises the rate a little, a
+// lost one, or a smoothed RTT well above the lowest seen (queues building up
+// somewhere on the path), cuts it by Decrease, at most once per round trip.
+// A client on a clean link stays at the full tick rate.
+class SnapshotRate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr float MaxRate = static_cast<float>(serverTickRate);
+    static constexpr float MinRate = 2.f;
+    // Snapshots per second gained per second of clean delivery.
+    static constexpr float Increase = 4.f;
+    static constexpr float Decrease = 0.7f;
+    static constexpr float DelayThresholdMs = 100.f;
+
+    // Called once per server tick; true when this tick's snapshot goes out.
+    bool dueThisTick();
+
+    void onDelivered(size_t bytes, float srttMs, Clock::time_point now);
+    void onLost(float srttMs, Clock::time_point now);
+
+    // Snapshots per second currently allowed.
+    float rate() const { return m_rate; }
+    // Snapshot bytes per second the client acknowledged lately.
+    float bandwidth() const { return m_bandwidth; }
+    // Recent fraction of snapshots lost, smoothed.
+    float lossRate() const { return m_loss; }
+
+private:
+    void decrease(float srttMs, Clock::time_point now);
+
+    float m_rate = MaxRate;
+    float m_credit = 0.f;
+    Clock::time_point m_lastDecrease;
+    float m_minRttMs = 0.f;
+    float m_loss = 0.f;
+
+    size_t m_windowBytes = 0;
+    Clock::time_point m_windowStart;
+    float m_bandwidth = 0.f;
+};
+
+#endif // SNAPSHOT_RATE_HPP
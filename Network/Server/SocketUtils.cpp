@@ -7,12 +7,18 @@
 #include <cstring>
 #include <cstdlib>
 
-int initializeSocket(int port) {
+int initializeSocket(int port, bool reusePort) {
     int sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock < 0) {
         std::cerr << "[Server] Socket creation failed.\n";
         exit(1);
     }
+    int one = 1;
+    if (reusePort && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+        std::cerr << "[Server] SO_REUSEPORT failed.\n";
+        close(sock);
+        exit(1);
+    }
     sockaddr_in serverAddr;
     std::memset(&serverAddr, 0, sizeof(serverAddr));
     serverAddr.sin_family      = AF_INET;
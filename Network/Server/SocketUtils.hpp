@@ -1,6 +1,8 @@
 #ifndef SOCKET_UTILS_HPP
 #define SOCKET_UTILS_HPP
 
-int initializeSocket(int port);
+// Binds a UDP socket on every interface. With `reusePort`, more sockets can
+// later bind the same port and share its traffic (see ReceiveShards).
+int initializeSocket(int port, bool reusePort = false);
 
 #endif // SOCKET_UTILS_HPP
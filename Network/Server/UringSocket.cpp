@@ -0,0 +1,303 @@
+#include "UringSocket.hpp"
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr uint64_t receiveTag = 0;
+constexpr uint64_t sendTag = 1ull << 32;
+constexpr uint64_t watchTag = 2ull << 32;
+constexpr uint16_t receiveGroup = 0;
+constexpr size_t receiveBufferSize = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + maxPacketSize;
+
+bool opSupported(const io_uring_probe* probe, uint8_t op) {
+    return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+}
+
+} // namespace
+
+UringSocket::~UringSocket() {
+    if (m_bufRing)
+        munmap(m_bufRing, m_bufRingSize);
+    if (m_sqes)
+        munmap(m_sqes, m_sqesSize);
+    if (m_cqMap && m_cqMap != m_sqMap)
+        munmap(m_cqMap, m_cqMapSize);
+    if (m_sqMap)
+        munmap(m_sqMap, m_sqMapSize);
+    if (m_ring >= 0)
+        close(m_ring);
+}
+
+bool UringSocket::open(int sock) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = CompletionEntries;
+    m_ring = static_cast<int>(syscall(__NR_io_uring_setup, SubmissionEntries, &params));
+    if (m_ring < 0)
+        return false;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG))
+        return false;
+
+    // Multishot RECVMSG needs 6.0, registered buffers on SEND_ZC 6.0 too.
+    char probeStorage[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)] = {};
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeStorage);
+    if (syscall(__NR_io_uring_register, m_ring, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+        !opSupported(probe, IORING_OP_RECVMSG) || !opSupported(probe, IORING_OP_SEND_ZC))
+        return false;
+
+    m_sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_sqMapSize = m_cqMapSize = std::max(m_sqMapSize, m_cqMapSize);
+    m_sqMap = mmap(nullptr, m_sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   m_ring, IORING_OFF_SQ_RING);
+    if (m_sqMap == MAP_FAILED) {
+        m_sqMap = nullptr;
+        return false;
+    }
+    m_cqMap = m_sqMap;
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_ring, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(m_sqMap);
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    for (unsigned i = 0; i < m_sqEntries; i++)
+        m_sqArray[i] = i;
+    char* cq = static_cast<char*>(m_cqMap);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+
+    // Receive side: a provided buffer ring the kernel picks from for every
+    // datagram of the multishot receive.
+    m_bufRingSize = ReceiveBuffers * sizeof(io_uring_buf);
+    void* bufRing = mmap(nullptr, m_bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufRing == MAP_FAILED)
+        return false;
+    m_bufRing = static_cast<io_uring_buf_ring*>(bufRing);
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(m_bufRing);
+    reg.ring_entries = ReceiveBuffers;
+    reg.bgid = receiveGroup;
+    if (syscall(__NR_io_uring_register, m_ring, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        return false;
+    m_receiveBuffers.resize(ReceiveBuffers * receiveBufferSize);
+    for (unsigned i = 0; i < ReceiveBuffers; i++)
+        recycleBuffer(static_cast<uint16_t>(i));
+
+    // Send side: one registered region split into maxPacketSize slots.
+    m_sendBuffers.resize(SendSlots * maxPacketSize);
+    m_sendAddrs.resize(SendSlots);
+    iovec region{m_sendBuffers.data(), m_sendBuffers.size()};
+    if (syscall(__NR_io_uring_register, m_ring, IORING_REGISTER_BUFFERS, &region, 1) < 0)
+        return false;
+    m_freeSendSlots.reserve(SendSlots);
+    for (unsigned i = SendSlots; i-- > 0;)
+        m_freeSendSlots.push_back(static_cast<uint16_t>(i));
+
+    m_sock = sock;
+    m_receiveMsg.msg_namelen = sizeof(sockaddr_in);
+    return armReceive() && flush();
+}
+
+int UringSocket::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize) {
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ring, toSubmit, minComplete, flags, arg, argSize));
+    if (ret > 0)
+        m_toSubmit -= std::min(static_cast<unsigned>(ret), m_toSubmit);
+    return ret;
+}
+
+io_uring_sqe* UringSocket::nextSqe() {
+    unsigned tail = *m_sqTail;
+    if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+        flush();
+        if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+            return nullptr;
+    }
+    io_uring_sqe* sqe = &m_sqes[tail & m_sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+bool UringSocket::armReceive() {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = m_sock;
+    sqe->addr = reinterpret_cast<uint64_t>(&m_receiveMsg);
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = receiveGroup;
+    sqe->user_data = receiveTag;
+    __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+    m_receiveArmed = true;
+    return true;
+}
+
+bool UringSocket::watch(int fd) {
+    m_watchFd = fd;
+    return armWatch();
+}
+
+bool UringSocket::armWatch() {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_watchFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = watchTag;
+    __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+    m_watchArmed = true;
+    return true;
+}
+
+void UringSocket::recycleBuffer(uint16_t bid) {
+    // Not m_bufRing->bufs: in C++ the header's flex-array wrapper puts it
+    // 8 bytes past where the kernel reads entries.
+    io_uring_buf &buf = reinterpret_cast<io_uring_buf*>(m_bufRing)[m_bufTail & (ReceiveBuffers - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(&m_receiveBuffers[bid * receiveBufferSize]);
+    buf.len = static_cast<uint32_t>(receiveBufferSize);
+    buf.bid = bid;
+    m_bufTail++;
+    __atomic_store_n(&m_bufRing->tail, m_bufTail, __ATOMIC_RELEASE);
+}
+
+bool UringSocket::queue(const sockaddr_in &to, const char* data, size_t len) {
+    if (len > maxPacketSize)
+        return false;
+    io_uring_sqe* sqe = m_freeSendSlots.empty() ? nullptr : nextSqe();
+    if (!sqe) {
+        return sendto(m_sock, data, len, 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) >= 0;
+    }
+    uint16_t slot = m_freeSendSlots.back();
+    m_freeSendSlots.pop_back();
+    char* buffer = &m_sendBuffers[slot * maxPacketSize];
+    std::memcpy(buffer, data, len);
+    m_sendAddrs[slot] = to;
+    sqe->opcode = IORING_OP_SEND_ZC;
+    sqe->fd = m_sock;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+    sqe->buf_index = 0;
+    sqe->addr2 = reinterpret_cast<uint64_t>(&m_sendAddrs[slot]);
+    sqe->addr_len = sizeof(sockaddr_in);
+    sqe->user_data = sendTag | slot;
+    __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+    return true;
+}
+
+bool UringSocket::flush() {
+    while (m_toSubmit > 0) {
+        if (enter(m_toSubmit, 0, 0, nullptr, 0) < 0 && errno != EINTR) {
+            std::cerr << "[Server] io_uring submit failed: " << std::strerror(errno) << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UringSocket::waitForCompletions(Clock::time_point deadline) {
+    if (m_woken) {
+        m_woken = false;
+        flush();
+        return false;
+    }
+    if (!m_receiveArmed)
+        armReceive();
+    if (m_watchFd >= 0 && !m_watchArmed)
+        armWatch();
+    if (__atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE) != *m_cqHead)
+        return flush();
+    auto now = Clock::now();
+    if (now >= deadline) {
+        flush();
+        return false;
+    }
+    auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+    __kernel_timespec ts;
+    ts.tv_sec = wait / 1000000000;
+    ts.tv_nsec = wait % 1000000000;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    // ETIME and EINTR just mean there is nothing to reap yet.
+    enter(m_toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    return true;
+}
+
+bool UringSocket::nextDatagram(sockaddr_in &from, const char* &data, size_t &len) {
+    if (m_heldBuffer >= 0) {
+        recycleBuffer(static_cast<uint16_t>(m_heldBuffer));
+        m_heldBuffer = -1;
+    }
+    unsigned head = *m_cqHead;
+    while (head != __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe cqe = m_cqes[head & m_cqMask];
+        __atomic_store_n(m_cqHead, ++head, __ATOMIC_RELEASE);
+
+        if (cqe.user_data == watchTag) {
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                m_watchArmed = false;
+            m_woken = true;
+            continue;
+        }
+        if (cqe.user_data & sendTag) {
+            if (cqe.res < 0 && !(cqe.flags & IORING_CQE_F_NOTIF))
+                std::cerr << "[Server] io_uring send failed: " << std::strerror(-cqe.res) << "\n";
+            // A zero-copy send owns its slot until the notification arrives.
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                m_freeSendSlots.push_back(static_cast<uint16_t>(cqe.user_data & 0xffff));
+            continue;
+        }
+
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+            m_receiveArmed = false;
+        if (cqe.res < 0 || !(cqe.flags & IORING_CQE_F_BUFFER)) {
+            if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED)
+                std::cerr << "[Server] io_uring receive failed: " << std::strerror(-cqe.res) << "\n";
+            continue;
+        }
+        uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        const char* buffer = &m_receiveBuffers[bid * receiveBufferSize];
+        const auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+        size_t offset = sizeof(io_uring_recvmsg_out) + m_receiveMsg.msg_namelen;
+        if (static_cast<size_t>(cqe.res) < offset || (out->flags & MSG_TRUNC) ||
+            out->namelen < sizeof(sockaddr_in)) {
+            recycleBuffer(bid);
+            continue;
+        }
+        std::memcpy(&from, buffer + sizeof(io_uring_recvmsg_out), sizeof(sockaddr_in));
+        data = buffer + offset;
+        len = std::min<size_t>(out->payloadlen, static_cast<size_t>(cqe.res) - offset);
+        m_heldBuffer = bid;
+        return true;
+    }
+    return false;
+}
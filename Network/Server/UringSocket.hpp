@@ -0,0 +1,116 @@
+#ifndef URING_SOCKET_HPP
+#define URING_SOCKET_HPP
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Protocol/Protocol.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+// io_uring transport for the server's UDP socket, driven entirely from the
+// game loop thread. One multishot RECVMSG keeps receiving into a provided
+// buffer ring, so incoming datagrams cost no syscall of their own; sends are
+// SEND_ZC from a registered buffer. Queued sends are submitted by the same
+// io_uring_enter that waits for completions.
+//
+// Talks to the kernel through raw syscalls; open() returns false when the
+// running kernel lacks any of the features used, and the caller falls back
+// to DatagramRing.
+class UringSocket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned SubmissionEntries = 256;
+    static constexpr unsigned CompletionEntries = 1024;
+    static constexpr unsigned ReceiveBuffers = 256;    // power of two
+    static constexpr unsigned SendSlots = 256;
+
+    UringSocket() = default;
+    UringSocket(const UringSocket &) = delete;
+    UringSocket &operator=(const UringSocket &) = delete;
+    ~UringSocket();
+
+    bool open(int sock);
+
+    // Copies a datagram into a free registered send slot. Falls back to a
+    // plain sendto when every slot is still in flight.
+    bool queue(const sockaddr_in &to, const char* data, size_t len);
+    // Submits queued sends without waiting.
+    bool flush();
+
+    // Makes poll() return early each time `fd` becomes readable. Reading it
+    // is up to the caller.
+    bool watch(int fd);
+
+    // Submits queued sends, then calls onDatagram(from, data, len) for every
+    // datagram that arrives until `deadline` or a watched fd wakes us.
+    // Replies queued by the callback go out on the next wait.
+    template<typename OnDatagram>
+    void poll(Clock::time_point deadline, OnDatagram onDatagram);
+
+private:
+    bool waitForCompletions(Clock::time_point deadline);
+    // Consumes completions until one carries a datagram. The datagram stays
+    // valid until the next call.
+    bool nextDatagram(sockaddr_in &from, const char* &data, size_t &len);
+    io_uring_sqe* nextSqe();
+    bool armReceive();
+    bool armWatch();
+    void recycleBuffer(uint16_t bid);
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize);
+
+    int m_sock = -1;
+    int m_ring = -1;
+
+    void* m_sqMap = nullptr;
+    size_t m_sqMapSize = 0;
+    void* m_cqMap = nullptr;
+    size_t m_cqMapSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned m_toSubmit = 0;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned m_cqMask = 0;
+
+    io_uring_buf_ring* m_bufRing = nullptr;
+    size_t m_bufRingSize = 0;
+    std::vector<char> m_receiveBuffers;
+    uint16_t m_bufTail = 0;
+    int m_heldBuffer = -1;
+    msghdr m_receiveMsg{};
+    bool m_receiveArmed = false;
+
+    int m_watchFd = -1;
+    bool m_watchArmed = false;
+    bool m_woken = false;
+
+    std::vector<char> m_sendBuffers;
+    std::vector<sockaddr_in> m_sendAddrs;
+    std::vector<uint16_t> m_freeSendSlots;
+};
+
+template<typename OnDatagram>
+void UringSocket::poll(Clock::time_point deadline, OnDatagram onDatagram) {
+    sockaddr_in from;
+    const char* data = nullptr;
+    size_t len = 0;
+    while (waitForCompletions(deadline)) {
+        while (nextDatagram(from, data, len))
+            onDatagram(from, data, len);
+    }
+}
+
+#endif // URING_SOCKET_HPP
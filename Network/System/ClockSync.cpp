@@ -0,0 +1,25 @@
+#include "ClockSync.hpp"
+
+void ClockSync::addSample(uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4) {
+    uint32_t roundTrip = t4 - t1;
+    uint32_t serverTime = t3 - t2;
+    // A reply that took the server longer than the whole round trip is
+    // from a confused peer; keep the estimate we have.
+    if (serverTime > roundTrip)
+        return;
+
+    Sample &s = samples[next];
+    s.delay = roundTrip - serverTime;
+    s.offset = (t3 - t4) + s.delay / 2;
+    next = (next + 1) % Samples;
+    if (count < Samples)
+        count++;
+
+    const Sample* best = &samples[0];
+    for (size_t i = 1; i < count; i++) {
+        if (samples[i].delay < best->delay)
+            best = &samples[i];
+    }
+    offset = best->offset;
+    delay = best->delay;
+}
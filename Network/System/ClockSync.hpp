@@ -0,0 +1,46 @@
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Estimates how far the server's getCurrentTimeMS() is from ours, NTP
+// style, from PING/PONG exchanges. With t1/t4 our send/receive times and
+// t2/t3 the server's, an exchange gives
+//     delay  = (t4 - t1) - (t3 - t2)
+//     offset = ((t2 - t1) + (t3 - t4)) / 2 = (t3 - t4) + delay / 2
+// The second form keeps the arithmetic modulo 2^32, so the two clocks may
+// be any distance apart. Queueing on one path skews an offset by up to half
+// the extra delay, so of the last Samples exchanges the one with the lowest
+// delay is used, as NTP's clock filter does.
+class ClockSync {
+public:
+    static constexpr size_t Samples = 8;
+
+    void addSample(uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4);
+
+    bool synced() const { return count > 0; }
+    size_t sampleCount() const { return count; }
+
+    // Server clock minus ours, modulo 2^32.
+    uint32_t offsetMs() const { return offset; }
+    // Network round trip of the sample in use, server time excluded.
+    uint32_t delayMs() const { return delay; }
+
+    uint32_t toServerTime(uint32_t localMs) const { return localMs + offset; }
+    uint32_t toLocalTime(uint32_t serverMs) const { return serverMs - offset; }
+
+private:
+    struct Sample {
+        uint32_t offset;
+        uint32_t delay;
+    };
+    Sample samples[Samples] = {};
+    size_t count = 0;
+    size_t next = 0;
+
+    uint32_t offset = 0;
+    uint32_t delay = 0;
+};
+
+#endif // CLOCK_SYNC_HPP
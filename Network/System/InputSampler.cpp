@@ -0,0 +1,37 @@
+#include "InputSampler.hpp"
+
+InputSampler::InputSampler(float rateHz, float heartbeatSeconds)
+    : interval(rateHz > 0.0f ? 1.0f / rateHz : 0.0f),
+      heartbeat(heartbeatSeconds)
+{
+}
+
+bool InputSampler::update(float dt, const PlayerInputPayload &current, PlayerInputPayload &out) {
+    sinceSend += dt;
+    pendingShoot = pendingShoot || current.shoot;
+    if (hasSent && sinceSend < interval)
+        return false;
+    bool changed = !hasSent || pendingShoot || !sameHeld(current, lastSent);
+    if (!changed && sinceSend < heartbeat)
+        return false;
+
+    out = current;
+    out.shoot = pendingShoot;
+    pendingShoot = false;
+    lastSent = out;
+    hasSent = true;
+    sinceSend = 0.0f;
+    return true;
+}
+
+void InputSampler::reset() {
+    sinceSend = 0.0f;
+    hasSent = false;
+    pendingShoot = false;
+    lastSent = PlayerInputPayload{};
+}
+
+bool InputSampler::sameHeld(const PlayerInputPayload &a, const PlayerInputPayload &b) {
+    return a.netID == b.netID && a.up == b.up && a.down == b.down &&
+           a.left == b.left && a.right == b.right;
+}
@@ -0,0 +1,31 @@
+#ifndef INPUT_SAMPLER_HPP
+#define INPUT_SAMPLER_HPP
+
+#include "../Protocol/Protocol.hpp"
+
+// Decides which frames' input is worth a PLAYER_INPUT packet. Input is read
+// every frame, but at most `rateHz` packets per second go out: one as soon
+// as the held buttons change or a shot is pending, otherwise a heartbeat
+// every `heartbeatSeconds`. A shot pressed between two sends is kept until
+// the next one, so edge-triggered actions are never lost.
+class InputSampler {
+public:
+    explicit InputSampler(float rateHz = static_cast<float>(serverTickRate), float heartbeatSeconds = 0.25f);
+
+    // Feed the input read this frame. Returns true when `out` should be sent.
+    bool update(float dt, const PlayerInputPayload &current, PlayerInputPayload &out);
+    // Forget what was sent, e.g. when returning to the lobby.
+    void reset();
+
+private:
+    static bool sameHeld(const PlayerInputPayload &a, const PlayerInputPayload &b);
+
+    float interval;
+    float heartbeat;
+    float sinceSend = 0.0f;
+    bool hasSent = false;
+    bool pendingShoot = false;
+    PlayerInputPayload lastSent{};
+};
+
+#endif // INPUT_SAMPLER_HPP
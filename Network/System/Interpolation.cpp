@@ -0,0 +1,80 @@
+#include "Interpolation.hpp"
+#include <algorithm>
+
+namespace {
+
+// Server times wrap; compare them by signed difference.
+int32_t timeDiff(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b);
+}
+
+// Weight of the newest interval in the smoothed snapshot interval.
+constexpr float intervalGain = 0.1f;
+
+} // namespace
+
+void PositionHistory::push(uint32_t serverTimeMs, float x, float y) {
+    samples[next] = Sample{serverTimeMs, x, y};
+    next = (next + 1) % Size;
+    if (count < Size)
+        count++;
+}
+
+bool PositionHistory::sample(uint32_t renderTimeMs, float &x, float &y) const {
+    if (count == 0)
+        return false;
+
+    const Sample &newest = at(0);
+    int32_t ahead = timeDiff(renderTimeMs, newest.time);
+    if (ahead >= 0) {
+        x = newest.x;
+        y = newest.y;
+        if (count < 2)
+            return true;
+        const Sample &prev = at(1);
+        int32_t span = timeDiff(newest.time, prev.time);
+        if (span <= 0)
+            return true;
+        float t = static_cast<float>(std::min<int32_t>(ahead, MaxExtrapolationMs)) / span;
+        x += (newest.x - prev.x) * t;
+        y += (newest.y - prev.y) * t;
+        return true;
+    }
+
+    for (size_t i = 1; i < count; i++) {
+        const Sample &older = at(i);
+        int32_t since = timeDiff(renderTimeMs, older.time);
+        if (since < 0)
+            continue;
+        const Sample &newer = at(i - 1);
+        float t = static_cast<float>(since) / timeDiff(newer.time, older.time);
+        x = older.x + (newer.x - older.x) * t;
+        y = older.y + (newer.y - older.y) * t;
+        return true;
+    }
+
+    // Older than anything kept, e.g. an entity that just appeared.
+    const Sample &oldest = at(count - 1);
+    x = oldest.x;
+    y = oldest.y;
+    return true;
+}
+
+void InterpolationDelay::onSnapshot(uint32_t serverTimeMs) {
+    if (hasLast) {
+        int32_t interval = timeDiff(serverTimeMs, lastTime);
+        if (interval > 0) {
+            if (intervalMs == 0.f)
+                intervalMs = static_cast<float>(interval);
+            else
+                intervalMs += intervalGain * (interval - intervalMs);
+        }
+    }
+    lastTime = serverTimeMs;
+    hasLast = true;
+}
+
+uint32_t InterpolationDelay::delayMs() const {
+    uint32_t delay = static_cast<uint32_t>(2.f * intervalMs);
+    return std::clamp(delay, MinDelayMs, MaxDelayMs);
+}
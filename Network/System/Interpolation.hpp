@@ -0,0 +1,55 @@
+#ifndef INTERPOLATION_HPP
+#define INTERPOLATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "../Protocol/Protocol.hpp"
+
+// Where one remote entity was in the last few snapshots, stamped with the
+// snapshots' server times. Rendering samples it at a time slightly behind
+// the newest snapshot, so there is almost always a snapshot on either side
+// to blend between; positions then move smoothly at the render rate even
+// though the server only sends a handful of snapshots a second.
+class PositionHistory {
+public:
+    static constexpr size_t Size = 8;
+    // How far past the newest snapshot a position is projected along its
+    // last velocity before it stops and waits for the next one.
+    static constexpr uint32_t MaxExtrapolationMs = 100;
+
+    // Samples must come in increasing server time.
+    void push(uint32_t serverTimeMs, float x, float y);
+    // Position at renderTimeMs; false if nothing was pushed yet.
+    bool sample(uint32_t renderTimeMs, float &x, float &y) const;
+
+private:
+    struct Sample {
+        uint32_t time;
+        float x, y;
+    };
+    // i = 0 is the newest sample.
+    const Sample &at(size_t i) const { return samples[(next + Size - 1 - i) % Size]; }
+
+    Sample samples[Size] = {};
+    size_t count = 0;
+    size_t next = 0;
+};
+
+// How far behind the server the client renders. Two snapshot intervals
+// ride out one lost or late snapshot; the interval is measured rather than
+// assumed because the server lowers a client's snapshot rate on a bad link.
+class InterpolationDelay {
+public:
+    static constexpr uint32_t MinDelayMs = 2 * 1000 / serverTickRate;
+    static constexpr uint32_t MaxDelayMs = 500;
+
+    void onSnapshot(uint32_t serverTimeMs);
+    uint32_t delayMs() const;
+
+private:
+    uint32_t lastTime = 0;
+    bool hasLast = false;
+    float intervalMs = 0.f;
+};
+
+#endif // INTERPOLATION_HPP
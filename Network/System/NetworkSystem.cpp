@@ -1,10 +1,16 @@
 #include "NetworkSystem.hpp"
+#include "../Protocol/SnapshotDelta.hpp"
+#include "../Protocol/Compression.hpp"
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
 #include <iostream>
 #include <cstring>
 #include <unordered_set>
 
-NetworkSystem::NetworkSystem(const std::string &serverIP, int serverPort, int clientPort)
-    : localNetworkID(clientPort)
+NetworkSystem::NetworkSystem(const std::string &serverIP, int serverPort, int clientPort,
+                             LocalPrediction::MoveRule predictMove)
+    : localNetworkID(clientPort), prediction(predictMove)
 {
     sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock < 0) {
@@ -34,9 +40,9 @@ NetworkSystem::~NetworkSystem() {
     close(sock);
 }
 
-bool NetworkSystem::sendRaw(const std::string &data) {
+bool NetworkSystem::sendRaw(const char* data, size_t len) {
     std::lock_guard<std::mutex> lock(socketMutex);
-    int sent = sendto(sock, data.c_str(), static_cast<int>(data.size()), 0,
+    int sent = sendto(sock, data, static_cast<int>(len), 0,
                       reinterpret_cast<struct sockaddr*>(&serverAddr), sizeof(serverAddr));
     if (sent < 0) {
         std::cerr << "[NetworkSystem] sendRaw failed.\n";
@@ -46,264 +52,384 @@ bool NetworkSystem::sendRaw(const std::string &data) {
 }
 
 bool NetworkSystem::sendPacket(uint8_t type, const void* payload, size_t payloadSize, bool important) {
-    MessageHeader header;
-    header.type = type;
-    header.sequence = nextSequence++;
-    header.timestamp = getCurrentTimeMS();
-    header.flags = important ? 1 : 0;
-
-    size_t totalSize = sizeof(MessageHeader) + payloadSize;
-    std::vector<char> packet(totalSize);
-    std::memcpy(packet.data(), &header, sizeof(MessageHeader));
-    if (payload && payloadSize > 0) {
-        std::memcpy(packet.data() + sizeof(MessageHeader), payload, payloadSize);
+    char body[maxMessageBody];
+    size_t bodyLen = 0;
+    if (!encodeMessageBody(type, payload, payloadSize, body, sizeof(body), bodyLen)) {
+        std::cerr << "[NetworkSystem] Cannot encode message type " << static_cast<int>(type) << ".\n";
+        return false;
     }
 
-    {
-        std::lock_guard<std::mutex> lock(socketMutex);
-        int sentBytes = sendto(sock, packet.data(), static_cast<int>(totalSize), 0,
-                               reinterpret_cast<struct sockaddr*>(&serverAddr), sizeof(serverAddr));
-        if (sentBytes < 0) {
-            std::cerr << "[NetworkSystem] sendto failed.\n";
+    std::lock_guard<std::mutex> lock(channelMutex);
+    if (important) {
+        if (!channel.sendReliable(type, body, bodyLen)) {
+            std::cerr << "[NetworkSystem] Too many reliable messages in flight.\n";
             return false;
         }
+        return true;
     }
 
-    if (important) {
-        PendingMessage pm;
-        pm.data = packet;
-        pm.timeSent = std::chrono::steady_clock::now();
-        std::lock_guard<std::mutex> lock(pendingMutex);
-        pendingMessages[header.sequence] = pm;
+    MessageHeader header;
+    header.type = type;
+    header.flags = 0;
+    header.reliableID = 0;
+    if (!outgoing.add(channel, header, body, bodyLen, DatagramSender{this})) {
+        std::cerr << "[NetworkSystem] Cannot send message type " << static_cast<int>(type) << ".\n";
+        return false;
     }
+    return true;
+}
 
+bool NetworkSystem::sendInput(const PlayerInputPayload &input) {
+    size_t kept = inputHistory.count < inputRedundancy ? inputHistory.count : inputRedundancy - 1;
+    for (size_t i = kept; i > 0; i--)
+        inputHistory.inputs[i] = inputHistory.inputs[i - 1];
+    inputHistory.inputs[0] = input;
+    inputHistory.inputs[0].tick = ++inputTick;
+    inputHistory.count = static_cast<uint8_t>(kept + 1);
+    prediction.onInputSent(inputHistory.inputs[0], LocalPrediction::Clock::now());
+    if (!sendPacket(static_cast<uint8_t>(MessageType::PLAYER_INPUT), &inputHistory, sizeof(inputHistory), false))
+        return false;
+    // Input is latency-sensitive: send now, with whatever else is queued.
+    std::lock_guard<std::mutex> lock(channelMutex);
+    processPendingMessages();
     return true;
 }
 
-bool NetworkSystem::sendAck(uint32_t sequence) {
-    AckPayload ack;
-    ack.ackSequence = sequence;
-    return sendPacket(static_cast<uint8_t>(MessageType::ACK), &ack, sizeof(ack), false);
+bool NetworkSystem::DatagramSender::operator()(const char* data, size_t len) const {
+    std::lock_guard<std::mutex> sockLock(owner->socketMutex);
+    int sentBytes = sendto(owner->sock, data, static_cast<int>(len), 0,
+                           reinterpret_cast<struct sockaddr*>(&owner->serverAddr), sizeof(owner->serverAddr));
+    if (sentBytes < 0) {
+        std::cerr << "[NetworkSystem] sendto failed.\n";
+        return false;
+    }
+    return true;
 }
 
+// Caller holds channelMutex.
 void NetworkSystem::processPendingMessages() {
+    auto now = ReliableChannel::Clock::now();
+    DatagramSender send{this};
+    channel.flushReliable(now, [&](const MessageHeader &h, const char* body, size_t len) {
+        outgoing.add(channel, h, body, len, send);
+    });
+    if (channel.abandonedMessages() != reportedAbandoned) {
+        reportedAbandoned = channel.abandonedMessages();
+        std::cerr << "[NetworkSystem] Server stopped acknowledging; "
+                  << reportedAbandoned << " reliable message(s) dropped.\n";
+    }
+    outgoing.flush(channel, send, channel.needsAck(now));
+}
+
+void NetworkSystem::update(float /*dt*/, Engine::EntityManager &em, Engine::ComponentManager &cm) {
+    if (world.consume()) {
+        const ReceivedWorld &w = world.front();
+        interpolationDelay.onSnapshot(w.time.serverTimeMs);
+        applyGameState(w.state, w.time.serverTimeMs, w.hasInputAck ? &w.inputAck : nullptr, em, cm);
+    }
+    interpolateRemoteEntities(cm);
+    updateLocalPlayer(cm);
+}
+
+void NetworkSystem::pump() {
+    // Resends and delayed acks are checked every WheelTick; pings are due on their own schedule.
     auto now = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(pendingMutex);
-    for (auto &pair : pendingMessages) {
-        auto &pending = pair.second;
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - pending.timeSent).count();
-        if (elapsed > 100) {
-            packetLossCount++;
+    auto wait = std::min<std::chrono::steady_clock::duration>(nextPing - now, ReliableChannel::WheelTick);
+    int timeoutMs = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+    pollfd pfd{sock, POLLIN, 0};
+    if (poll(&pfd, 1, std::max(timeoutMs, 0)) > 0 && (pfd.revents & POLLIN))
+        receiveAll();
+
+    now = std::chrono::steady_clock::now();
+    if (now >= nextPing) {
+        // Ping faster until the clock filter has a full set of samples.
+        bool filling;
+        {
+            std::lock_guard<std::mutex> lock(clockMutex);
+            filling = clock.sampleCount() < ClockSync::Samples;
+        }
+        nextPing = now + (filling ? std::chrono::milliseconds(250) : std::chrono::milliseconds(1000));
+        lastPingSequence++;
+        PingPayload pp;
+        pp.pingSequence = lastPingSequence;
+        pp.clientSendTime = getCurrentTimeMS();
+        pingSentTime = now;
+        sendPacket(static_cast<uint8_t>(MessageType::PING), &pp, sizeof(pp), false);
+    }
+
+    // Everything queued since the last pump leaves in as few datagrams as possible.
+    std::lock_guard<std::mutex> lock(channelMutex);
+    processPendingMessages();
+}
+
+void NetworkSystem::receiveAll() {
+    while (true) {
+        int count = incoming.receiveQueued(sock);
+        if (count < 0) {
+            std::cerr << "[NetworkSystem] recvmmsg failed: " << std::strerror(errno) << "\n";
+            return;
+        }
+        for (int i = 0; i < count; i++)
+            handleDatagram(incoming.data(i), incoming.length(i));
+        if (static_cast<size_t>(count) < incoming.capacity())
+            return;
+    }
+}
+
+void NetworkSystem::handleDatagram(const char* data, size_t len) {
+    BitReader reader(data, len);
+    PacketHeader packet;
+    if (!readPacketHeader(reader, packet))
+        return;
+    auto now = ReliableChannel::Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        if (!channel.receive(packet, now))
+            return;
+        packetLoss.store(channel.lostPackets(), std::memory_order_relaxed);
+    }
+
+    MessageFrameReader frames(data, len, reader.bytesRead());
+    MessageHeader h;
+    const char* body = nullptr;
+    size_t bodyLen = 0;
+    while (frames.next(h, body, bodyLen)) {
+        if (h.flags & (messageReliable | messageNeedsAck)) {
+            std::lock_guard<std::mutex> lock(channelMutex);
+            channel.requestAck(now);
+            if ((h.flags & messageReliable) && !channel.acceptReliable(h.reliableID))
+                continue;
+        }
+        uint8_t type = h.type;
+        if (type == static_cast<uint8_t>(MessageType::FRAGMENT) &&
+            (!fragments.receive(body, bodyLen, now, type, body, bodyLen) ||
+             type == static_cast<uint8_t>(MessageType::FRAGMENT)))
+            continue;
+        if (h.flags & messageCompressed) {
+            bodyLen = decompressBody(body, bodyLen, inflated, sizeof(inflated), &snapshotDictionary());
+            if (bodyLen == 0)
+                continue;
+            body = inflated;
+        }
+        BitReader bodyReader(body, bodyLen);
+        handleMessage(bodyReader, type);
+    }
+}
+
+void NetworkSystem::handleMessage(BitReader &reader, uint8_t type) {
+    switch (type) {
+        case static_cast<uint8_t>(MessageType::START): {
             {
-                std::lock_guard<std::mutex> sockLock(socketMutex);
-                int sentBytes = sendto(sock, pending.data.data(), static_cast<int>(pending.data.size()), 0,
-                                       reinterpret_cast<struct sockaddr*>(&serverAddr), sizeof(serverAddr));
-                if (sentBytes >= 0) {
-                    pending.timeSent = now;
-                } else {
-                    std::cerr << "[NetworkSystem] Resend failed.\n";
+                std::lock_guard<std::mutex> lock(gameStartedMutex);
+                m_gameStarted = true;
+            }
+            std::cout << "[NetworkSystem] Received MSG_START: gameStarted set to true.\n";
+            break;
+        }
+        case static_cast<uint8_t>(MessageType::PONG): {
+            PingPayload pong;
+            if (readPayload(reader, pong)) {
+                if (pong.pingSequence == lastPingSequence) {
+                    auto now = std::chrono::steady_clock::now();
+                    float ms = std::chrono::duration<float, std::milli>(now - pingSentTime).count();
+                    latencyMs.store(ms, std::memory_order_relaxed);
+                }
+                // Late PONGs still carry a valid exchange; the filter weeds out slow ones.
+                if (pong.serverSendTime != 0) {
+                    std::lock_guard<std::mutex> lock(clockMutex);
+                    clock.addSample(pong.clientSendTime, pong.serverReceiveTime, pong.serverSendTime,
+                                    getCurrentTimeMS());
                 }
             }
+            break;
+        }
+        case static_cast<uint8_t>(MessageType::GAME_STATE): {
+            uint32_t seq;
+            SnapshotTime time;
+            GameStatePayload gs;
+            if (readSnapshotSequence(reader, seq) && readSnapshotTime(reader, time) && decodeSnapshot(reader, gs))
+                receiveSnapshot(seq, time, gs);
+            break;
+        }
+        case static_cast<uint8_t>(MessageType::GAME_STATE_DELTA): {
+            // The server only deltas against snapshots whose every packet we acked,
+            // so the baseline is normally here; if not, the delta is dropped.
+            uint32_t seq, baselineSeq;
+            SnapshotTime time;
+            if (readSnapshotSequence(reader, seq) && readDeltaBaseline(reader, seq, baselineSeq) &&
+                readSnapshotTime(reader, time)) {
+                const GameStatePayload* baseline = snapshots.find(baselineSeq);
+                GameStatePayload gs;
+                if (baseline && decodeSnapshotDelta(reader, *baseline, gs))
+                    receiveSnapshot(seq, time, gs);
+            }
+            break;
         }
+        case static_cast<uint8_t>(MessageType::INPUT_ACK): {
+            InputAckPayload ack;
+            if (readPayload(reader, ack))
+                inputAck = ack;
+            break;
+        }
+        case static_cast<uint8_t>(MessageType::LOBBY_STATUS): {
+            LobbyStatusPayload ls;
+            if (readPayload(reader, ls)) {
+                std::lock_guard<std::mutex> lock(lobbyMutex);
+                lobbyTotal = ls.totalClients;
+                lobbyReady = ls.readyClients;
+            }
+            break;
+        }
+        default:
+            break;
     }
 }
 
-void NetworkSystem::update(float dt, Engine::EntityManager &em, Engine::ComponentManager &cm) {
-    char buffer[2048];
-    int bytesReceived = 0;
+void NetworkSystem::receiveSnapshot(uint32_t sequence, const SnapshotTime &time, const GameStatePayload &gs) {
+    snapshots.store(sequence, gs);
+    // A late snapshot can still serve as a baseline, but must not roll the world back.
+    if (sequence <= lastSnapshotSequence)
+        return;
+    lastSnapshotSequence = sequence;
+
+    ReceivedWorld &w = world.back();
+    w.sequence = sequence;
+    w.time = time;
+    w.state = gs;
+    w.hasInputAck = inputAck.snapshotSequence == sequence;
+    w.inputAck = inputAck;
     {
-        std::lock_guard<std::mutex> lock(socketMutex);
-        bytesReceived = recvfrom(sock, buffer, sizeof(buffer), MSG_DONTWAIT, nullptr, nullptr);
+        std::lock_guard<std::mutex> lock(clockMutex);
+        latestSnapshotTime = time;
+        w.clockSynced = clock.synced();
+        w.clockOffsetMs = clock.offsetMs();
     }
+    world.publish();
+}
 
-    if (bytesReceived >= static_cast<int>(sizeof(MessageHeader))) {
-        MessageHeader header;
-        std::memcpy(&header, buffer, sizeof(MessageHeader));
-        uint32_t seq = header.sequence;
-
-        if (header.flags & 1)
-            sendAck(seq);
-
-        switch (header.type) {
-            case static_cast<uint8_t>(MessageType::ACK): {
-                if (bytesReceived >= static_cast<int>(sizeof(MessageHeader) + sizeof(AckPayload))) {
-                    AckPayload ack;
-                    std::memcpy(&ack, buffer + sizeof(MessageHeader), sizeof(AckPayload));
-                    std::lock_guard<std::mutex> lock(pendingMutex);
-                    pendingMessages.erase(ack.ackSequence);
+void NetworkSystem::applyGameState(const GameStatePayload &gs, uint32_t serverTimeMs, const InputAckPayload* inputAck,
+                                   Engine::EntityManager &em, Engine::ComponentManager &cm) {
+    {
+        std::unordered_set<int> updated;
+        for (int i = 0; i < gs.numEnemies; i++) {
+            int eID = gs.enemies[i].enemyID;
+            updated.insert(eID);
+            if (gs.enemies[i].health <= 0) {
+                if (remoteEnemies.count(eID)) {
+                    destroyRemoteEntity(remoteEnemies[eID], em);
+                    remoteEnemies.erase(eID);
                 }
-                break;
+                continue;
             }
-            case static_cast<uint8_t>(MessageType::START): {
-                {
-                    std::lock_guard<std::mutex> lock(gameStartedMutex);
-                    m_gameStarted = true;
-                }
-                std::cout << "[NetworkSystem] Received MSG_START: gameStarted set to true.\n";
-                break;
+            if (!remoteEnemies.count(eID)) {
+                Engine::Entity eEnt = em.createEntity();
+                cm.addComponent(eEnt, Position{gs.enemies[i].x, gs.enemies[i].y});
+                auto tex = cm.getGlobalTexture("enemy");
+                cm.addComponent(eEnt, Sprite{tex, tex.width, tex.height});
+                remoteEnemies[eID] = eEnt;
             }
-            case static_cast<uint8_t>(MessageType::PONG): {
-                if (bytesReceived >= static_cast<int>(sizeof(MessageHeader) + sizeof(PingPayload))) {
-                    PingPayload pong;
-                    std::memcpy(&pong, buffer + sizeof(MessageHeader), sizeof(PingPayload));
-                    if (pong.pingSequence == lastPingSequence) {
-                        auto now = std::chrono::steady_clock::now();
-                        float ms = std::chrono::duration<float, std::milli>(now - pingSentTime).count();
-                        latencyMs = ms;
-                    }
-                }
-                break;
+            remoteHistories[remoteEnemies[eID]].push(serverTimeMs, gs.enemies[i].x, gs.enemies[i].y);
+        }
+        for (auto it = remoteEnemies.begin(); it != remoteEnemies.end();) {
+            if (updated.find(it->first) == updated.end()) {
+                destroyRemoteEntity(it->second, em);
+                it = remoteEnemies.erase(it);
+            } else {
+                ++it;
             }
-            case static_cast<uint8_t>(MessageType::GAME_STATE): {
-                if (bytesReceived >= static_cast<int>(sizeof(MessageHeader) + sizeof(GameStatePayload))) {
-                    GameStatePayload gs;
-                    std::memcpy(&gs, buffer + sizeof(MessageHeader), sizeof(GameStatePayload));
-
-                    {
-                        std::lock_guard<std::mutex> lock(remoteEnemiesMutex);
-                        std::unordered_set<int> updated;
-                        for (int i = 0; i < gs.numEnemies; i++) {
-                            int eID = gs.enemies[i].enemyID;
-                            updated.insert(eID);
-                            if (gs.enemies[i].health <= 0) {
-                                if (remoteEnemies.count(eID)) {
-                                    em.destroyEntity(remoteEnemies[eID]);
-                                    remoteEnemies.erase(eID);
-                                }
-                                continue;
-                            }
-                            if (!remoteEnemies.count(eID)) {
-                                Engine::Entity eEnt = em.createEntity();
-                                cm.addComponent(eEnt, Position{gs.enemies[i].x, gs.enemies[i].y});
-                                auto tex = cm.getGlobalTexture("enemy");
-                                cm.addComponent(eEnt, Sprite{tex, tex.width, tex.height});
-                                remoteEnemies[eID] = eEnt;
-                            } else {
-                                Engine::Entity eEnt = remoteEnemies[eID];
-                                if (auto *pos = cm.getComponent<Position>(eEnt)) {
-                                    pos->x = gs.enemies[i].x;
-                                    pos->y = gs.enemies[i].y;
-                                }
-                            }
-                        }
-                        for (auto it = remoteEnemies.begin(); it != remoteEnemies.end();) {
-                            if (updated.find(it->first) == updated.end()) {
-                                em.destroyEntity(it->second);
-                                it = remoteEnemies.erase(it);
-                            } else {
-                                ++it;
-                            }
-                        }
-                    }
-                    {
-                        std::lock_guard<std::mutex> lock(remotePlayersMutex);
-                        std::unordered_set<int> updated;
-                        for (int i = 0; i < gs.numPlayers; i++) {
-                            int pid = gs.players[i].playerID;
-                            if (pid == getLocalNetworkID()) {
-                                if (auto *pos = cm.getComponent<Position>(0)) {
-                                    pos->x = gs.players[i].x;
-                                    pos->y = gs.players[i].y;
-                                }
-                                if (auto *hp = cm.getComponent<Health>(0)) {
-                                    hp->current = gs.players[i].health;
-                                }
-                                if (remotePlayers.count(pid)) {
-                                    em.destroyEntity(remotePlayers[pid]);
-                                    remotePlayers.erase(pid);
-                                }
-                                continue;
-                            }
-                            updated.insert(pid);
-                            if (gs.players[i].health <= 0) {
-                                if (remotePlayers.count(pid)) {
-                                    em.destroyEntity(remotePlayers[pid]);
-                                    remotePlayers.erase(pid);
-                                }
-                                continue;
-                            }
-                            if (!remotePlayers.count(pid)) {
-                                Engine::Entity pEnt = em.createEntity();
-                                cm.addComponent(pEnt, Position{gs.players[i].x, gs.players[i].y});
-                                auto rpTex = cm.getGlobalTexture("remotePlayer");
-                                cm.addComponent(pEnt, Sprite{rpTex, rpTex.width, rpTex.height});
-                                remotePlayers[pid] = pEnt;
-                            } else {
-                                Engine::Entity pEnt = remotePlayers[pid];
-                                if (auto *pos = cm.getComponent<Position>(pEnt)) {
-                                    pos->x = gs.players[i].x;
-                                    pos->y = gs.players[i].y;
-                                }
-                            }
-                        }
-                        for (auto it = remotePlayers.begin(); it != remotePlayers.end();) {
-                            if (updated.find(it->first) == updated.end()) {
-                                em.destroyEntity(it->second);
-                                it = remotePlayers.erase(it);
-                            } else {
-                                ++it;
-                            }
-                        }
-                    }
-
-                    {
-                        std::lock_guard<std::mutex> lock(remoteBulletsMutex);
-                        std::unordered_set<int> updated;
-                        for (int i = 0; i < gs.numBullets; i++) {
-                            auto &b = gs.bullets[i];
-                            updated.insert(b.bulletID);
-                            if (!remoteBullets.count(b.bulletID)) {
-                                Engine::Entity bEnt = em.createEntity();
-                                cm.addComponent(bEnt, Position{b.x, b.y});
-                                auto bulletTex = cm.getGlobalTexture("bullet");
-                                cm.addComponent(bEnt, Sprite{bulletTex, bulletTex.width, bulletTex.height});
-                                remoteBullets[b.bulletID] = bEnt;
-                            } else {
-                                Engine::Entity bEnt = remoteBullets[b.bulletID];
-                                if (auto *pos = cm.getComponent<Position>(bEnt)) {
-                                    pos->x = b.x;
-                                    pos->y = b.y;
-                                }
-                            }
-                        }
-                        for (auto it = remoteBullets.begin(); it != remoteBullets.end();) {
-                            if (updated.find(it->first) == updated.end()) {
-                                em.destroyEntity(it->second);
-                                it = remoteBullets.erase(it);
-                            } else {
-                                ++it;
-                            }
-                        }
-                    }
+        }
+    }
+    {
+        std::unordered_set<int> updated;
+        for (int i = 0; i < gs.numPlayers; i++) {
+            int pid = gs.players[i].playerID;
+            if (pid == getLocalNetworkID()) {
+                prediction.onServerState(gs.players[i].x, gs.players[i].y, inputAck, LocalPrediction::Clock::now());
+                if (auto *hp = cm.getComponent<Health>(0)) {
+                    hp->current = gs.players[i].health;
                 }
-                break;
+                if (remotePlayers.count(pid)) {
+                    destroyRemoteEntity(remotePlayers[pid], em);
+                    remotePlayers.erase(pid);
+                }
+                continue;
             }
-            case static_cast<uint8_t>(MessageType::LOBBY_STATUS): {
-                if (bytesReceived >= static_cast<int>(sizeof(MessageHeader) + sizeof(LobbyStatusPayload))) {
-                    LobbyStatusPayload ls;
-                    std::memcpy(&ls, buffer + sizeof(MessageHeader), sizeof(LobbyStatusPayload));
-                    std::lock_guard<std::mutex> lock(lobbyMutex);
-                    lobbyTotal = ls.totalClients;
-                    lobbyReady = ls.readyClients;
+            updated.insert(pid);
+            if (gs.players[i].health <= 0) {
+                if (remotePlayers.count(pid)) {
+                    destroyRemoteEntity(remotePlayers[pid], em);
+                    remotePlayers.erase(pid);
                 }
-                break;
+                continue;
+            }
+            if (!remotePlayers.count(pid)) {
+                Engine::Entity pEnt = em.createEntity();
+                cm.addComponent(pEnt, Position{gs.players[i].x, gs.players[i].y});
+                auto rpTex = cm.getGlobalTexture("remotePlayer");
+                cm.addComponent(pEnt, Sprite{rpTex, rpTex.width, rpTex.height});
+                remotePlayers[pid] = pEnt;
+            }
+            remoteHistories[remotePlayers[pid]].push(serverTimeMs, gs.players[i].x, gs.players[i].y);
+        }
+        for (auto it = remotePlayers.begin(); it != remotePlayers.end();) {
+            if (updated.find(it->first) == updated.end()) {
+                destroyRemoteEntity(it->second, em);
+                it = remotePlayers.erase(it);
+            } else {
+                ++it;
             }
-            default:
-                break;
         }
     }
 
-    processPendingMessages();
+    {
+        std::unordered_set<int> updated;
+        for (int i = 0; i < gs.numBullets; i++) {
+            auto &b = gs.bullets[i];
+            updated.insert(b.bulletID);
+            if (!remoteBullets.count(b.bulletID)) {
+                Engine::Entity bEnt = em.createEntity();
+                cm.addComponent(bEnt, Position{b.x, b.y});
+                auto bulletTex = cm.getGlobalTexture("bullet");
+                cm.addComponent(bEnt, Sprite{bulletTex, bulletTex.width, bulletTex.height});
+                remoteBullets[b.bulletID] = bEnt;
+            }
+            remoteHistories[remoteBullets[b.bulletID]].push(serverTimeMs, b.x, b.y);
+        }
+        for (auto it = remoteBullets.begin(); it != remoteBullets.end();) {
+            if (updated.find(it->first) == updated.end()) {
+                destroyRemoteEntity(it->second, em);
+                it = remoteBullets.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
 
-    static float pingTimer = 0.0f;
-    pingTimer += dt;
-    if (pingTimer >= 1.0f) {
-        pingTimer = 0.0f;
-        lastPingSequence++;
-        PingPayload pp;
-        pp.pingSequence = lastPingSequence;
-        pingSentTime = std::chrono::steady_clock::now();
-        sendPacket(static_cast<uint8_t>(MessageType::PING), &pp, sizeof(pp), false);
+void NetworkSystem::destroyRemoteEntity(Engine::Entity entity, Engine::EntityManager &em) {
+    remoteHistories.erase(entity);
+    em.destroyEntity(entity);
+}
+
+void NetworkSystem::interpolateRemoteEntities(Engine::ComponentManager &cm) {
+    // Until the clock is synced, show the newest snapshot as it is.
+    const ReceivedWorld &w = world.front();
+    uint32_t renderTime = w.time.serverTimeMs;
+    if (w.clockSynced)
+        renderTime = getCurrentTimeMS() + w.clockOffsetMs - interpolationDelay.delayMs();
+    for (auto &[entity, history] : remoteHistories) {
+        if (auto *pos = cm.getComponent<Position>(entity))
+            history.sample(renderTime, pos->x, pos->y);
+    }
+}
+
+void NetworkSystem::updateLocalPlayer(Engine::ComponentManager &cm) {
+    float x, y;
+    if (!prediction.position(LocalPrediction::Clock::now(), x, y))
+        return;
+    if (auto *pos = cm.getComponent<Position>(0)) {
+        pos->x = x;
+        pos->y = y;
     }
 }
 
@@ -313,17 +439,32 @@ bool NetworkSystem::isGameStarted() const {
 }
 
 float NetworkSystem::getLatency() const {
-    return latencyMs;
+    return latencyMs.load(std::memory_order_relaxed);
 }
 
 uint32_t NetworkSystem::getPacketLoss() const {
-    return packetLossCount;
+    return packetLoss.load(std::memory_order_relaxed);
 }
 
 int NetworkSystem::getLocalNetworkID() const {
     return localNetworkID;
 }
 
+bool NetworkSystem::isClockSynced() const {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    return clock.synced();
+}
+
+uint32_t NetworkSystem::serverTimeNow() const {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    return clock.toServerTime(getCurrentTimeMS());
+}
+
+SnapshotTime NetworkSystem::lastSnapshotTime() const {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    return latestSnapshotTime;
+}
+
 void NetworkSystem::getLobbyStatus(uint8_t &total, uint8_t &ready) {
     std::lock_guard<std::mutex> lock(lobbyMutex);
     total = lobbyTotal;
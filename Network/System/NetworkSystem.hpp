@@ -10,40 +10,94 @@
 #include <unordered_map>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <chrono>
 
 #include "../Protocol/Protocol.hpp"
-
+#include "../Protocol/SnapshotDelta.hpp"
+#include "../Protocol/Fragmentation.hpp"
+#include "../Protocol/Reliability.hpp"
+#include "../Protocol/PacketBuilder.hpp"
+#include "../Protocol/DatagramRing.hpp"
+#include "ClockSync.hpp"
+#include "Interpolation.hpp"
+#include "Prediction.hpp"
+
+#include "Engine/Core/TripleBuffer.hpp"
 #include "Engine/ECS/System.hpp"
 #include "Engine/ECS/EntityManager.hpp"
 #include "Engine/ECS/ComponentManager.hpp"
 #include "Game/Components/Components.hpp"
 
-struct PendingMessage {
-    std::vector<char> data;
-    std::chrono::steady_clock::time_point timeSent;
-};
-
 class NetworkSystem : public Engine::System {
 public:
-    NetworkSystem(const std::string &serverIP, int serverPort, int clientPort);
+    // Datagrams taken per recvmmsg.
+    static constexpr size_t receiveBatch = 16;
+
+    // predictMove is the game's player movement rule; without one the
+    // local player is drawn at its snapshot positions.
+    NetworkSystem(const std::string &serverIP, int serverPort, int clientPort,
+                  LocalPrediction::MoveRule predictMove = nullptr);
     ~NetworkSystem();
 
+    // Main thread, once per frame: applies the newest snapshot pump() has
+    // published to the ECS, then places remote entities and the local
+    // player where they are drawn this frame.
     void update(float dt, Engine::EntityManager &em, Engine::ComponentManager &cm) override;
-
-    bool sendRaw(const std::string &data);
+    // Network thread: waits for datagrams, at most until the next timer
+    // (ping, resend, delayed ack) is due, handles every one already queued,
+    // then pings and sends. Never touches the ECS; decoded snapshots reach
+    // update() through a triple buffer, so neither thread waits on the
+    // other for them.
+    void pump();
+
+    // Sends one datagram as is. Like everything on the send path it works
+    // from caller or fixed buffers; send_alloc_bench checks that sending
+    // never touches the heap.
+    bool sendRaw(const char* data, size_t len);
+    // Queues one message for the server. It leaves, coalesced with anything
+    // else queued, at the end of the next update() or with the next input.
     bool sendPacket(uint8_t type, const void* payload, size_t payloadSize, bool important = false);
-    bool sendAck(uint32_t sequence);
+    // Stamps `input` with the next input tick and sends it along with the
+    // previous inputRedundancy - 1 inputs. Main thread only: it feeds the
+    // local player's prediction.
+    bool sendInput(const PlayerInputPayload &input);
 
     bool isGameStarted() const;
     float getLatency() const;
     uint32_t getPacketLoss() const;
     int getLocalNetworkID() const;
 
+    // False until the first PONG with server times has come back.
+    bool isClockSynced() const;
+    // The server's getCurrentTimeMS() right now, as far as we can tell.
+    uint32_t serverTimeNow() const;
+    // Tick and server time of the newest snapshot received.
+    SnapshotTime lastSnapshotTime() const;
+
     void getLobbyStatus(uint8_t &total, uint8_t &ready);
 
 private:
+    // Sends queued messages and due reliable resends, or a bare ack if a
+    // receipt has waited too long for one.
     void processPendingMessages();
+    // Handles every datagram waiting in the socket, a batch per recvmmsg.
+    void receiveAll();
+    void handleDatagram(const char* data, size_t len);
+    void handleMessage(BitReader &reader, uint8_t type);
+    void receiveSnapshot(uint32_t sequence, const SnapshotTime &time, const GameStatePayload &gs);
+    void applyGameState(const GameStatePayload &gs, uint32_t serverTimeMs, const InputAckPayload* inputAck,
+                        Engine::EntityManager &em, Engine::ComponentManager &cm);
+    void destroyRemoteEntity(Engine::Entity entity, Engine::EntityManager &em);
+    // Moves remote entities to where they were InterpolationDelay behind
+    // the server's current time.
+    void interpolateRemoteEntities(Engine::ComponentManager &cm);
+    void updateLocalPlayer(Engine::ComponentManager &cm);
+    struct DatagramSender {
+        NetworkSystem* owner;
+        bool operator()(const char* data, size_t len) const;
+    };
+
     int sock;
     sockaddr_in serverAddr;
     int localNetworkID;
@@ -51,26 +105,75 @@ private:
     bool m_gameStarted = false;
     mutable std::mutex gameStartedMutex;
 
+    // Serializes sends, which come from both threads. Receiving is the
+    // network thread's alone and needs no lock.
     std::mutex socketMutex;
 
-    uint32_t nextSequence = 1;
-    std::unordered_map<uint32_t, PendingMessage> pendingMessages;
-    std::mutex pendingMutex;
+    // Sequence numbers, acks and reliable resends for the server connection,
+    // and the messages waiting to share the next datagram.
+    // Lock before socketMutex when both are needed.
+    ReliableChannel channel;
+    PacketBuilder outgoing;
+    mutable std::mutex channelMutex;
+    uint32_t reportedAbandoned = 0;
+    // channel.lostPackets(), readable without channelMutex
+    std::atomic<uint32_t> packetLoss{0};
+
+    // Recent inputs, newest first, repeated in every PLAYER_INPUT
+    uint32_t inputTick = 0;
+    PlayerInputBatch inputHistory{};
+
+    // The newest INPUT_ACK, matched to its snapshot by sequence
+    InputAckPayload inputAck{};
+
+    // Incoming datagrams, network thread only
+    DatagramRing incoming{receiveBatch};
 
     // Ping
     uint32_t lastPingSequence = 0;
     std::chrono::steady_clock::time_point pingSentTime;
-    float latencyMs = 0.0f;
-
-    uint32_t packetLossCount = 0;
+    std::chrono::steady_clock::time_point nextPing;
+    std::atomic<float> latencyMs{0.0f};
+
+    // Server clock estimate from the PING/PONG times
+    ClockSync clock;
+    SnapshotTime latestSnapshotTime;
+    mutable std::mutex clockMutex;
+
+    // Snapshots split across several datagrams
+    FragmentReassembler fragments;
+    // Bodies sent with messageCompressed, once decompressed
+    char inflated[maxReassembledSize];
+
+    // Snapshots kept as delta baselines
+    SnapshotRing snapshots;
+    uint32_t lastSnapshotSequence = 0;
+
+    // Network thread -> main thread: the newest snapshot with its INPUT_ACK,
+    // and the clock estimate to place it in time.
+    struct ReceivedWorld {
+        uint32_t sequence = 0;
+        SnapshotTime time;
+        GameStatePayload state{};
+        bool hasInputAck = false;
+        InputAckPayload inputAck{};
+        bool clockSynced = false;
+        uint32_t clockOffsetMs = 0;
+    };
+    Engine::TripleBuffer<ReceivedWorld> world;
+
+    // Everything below belongs to the main thread.
+
+    // Local player prediction from the inputs sent
+    LocalPrediction prediction;
 
     // Remote Entities
-    std::mutex remotePlayersMutex;
-    std::mutex remoteEnemiesMutex;
-    std::mutex remoteBulletsMutex;
     std::unordered_map<int, Engine::Entity> remotePlayers;
     std::unordered_map<int, Engine::Entity> remoteEnemies;
     std::unordered_map<int, Engine::Entity> remoteBullets;
+    // Recent snapshot positions of every remote entity, for interpolation
+    std::unordered_map<Engine::Entity, PositionHistory> remoteHistories;
+    InterpolationDelay interpolationDelay;
 
     // Lobby
     uint8_t lobbyTotal = 0;
@@ -0,0 +1,82 @@
+#include "Prediction.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float secondsBetween(LocalPrediction::Clock::time_point from, LocalPrediction::Clock::time_point to) {
+    return std::chrono::duration<float>(to - from).count();
+}
+
+} // namespace
+
+void LocalPrediction::onInputSent(const PlayerInputPayload &input, Clock::time_point now) {
+    if (!move)
+        return;
+    if (count == MaxPending) {
+        // The server stopped acking; the oldest input is the least useful.
+        first = (first + 1) % MaxPending;
+        count--;
+    }
+    pending[(first + count) % MaxPending] = Pending{input.tick, input.up, input.down, input.left, input.right, now};
+    count++;
+}
+
+void LocalPrediction::onServerState(float x, float y, const InputAckPayload* ack, Clock::time_point now) {
+    if (!ack && count > 0)
+        return;
+
+    float shownX = 0.f, shownY = 0.f;
+    bool shown = position(now, shownX, shownY);
+
+    if (ack) {
+        // The acked input stays: the server has only held it for heldMs so far.
+        while (count > 0 && static_cast<int32_t>(at(0).tick - ack->inputTick) < 0) {
+            first = (first + 1) % MaxPending;
+            count--;
+        }
+        ackTick = ack->inputTick;
+        ackHeldSeconds = ack->heldMs / 1000.f;
+    }
+    hasState = true;
+    baseX = x;
+    baseY = y;
+
+    correctionX = correctionY = 0.f;
+    correctionAt = now;
+    if (shown && move) {
+        float predictedX, predictedY;
+        predict(now, predictedX, predictedY);
+        float dx = shownX - predictedX;
+        float dy = shownY - predictedY;
+        lastError = std::hypot(dx, dy);
+        if (lastError <= SnapDistance) {
+            correctionX = dx;
+            correctionY = dy;
+        }
+    }
+}
+
+bool LocalPrediction::position(Clock::time_point now, float &x, float &y) const {
+    if (!hasState)
+        return false;
+    predict(now, x, y);
+    float fade = std::exp(-secondsBetween(correctionAt, now) / CorrectionSeconds);
+    x += correctionX * fade;
+    y += correctionY * fade;
+    return true;
+}
+
+void LocalPrediction::predict(Clock::time_point now, float &x, float &y) const {
+    x = baseX;
+    y = baseY;
+    for (size_t i = 0; i < count; i++) {
+        const Pending &p = at(i);
+        Clock::time_point until = i + 1 < count ? at(i + 1).sentAt : now;
+        float held = secondsBetween(p.sentAt, until);
+        if (p.tick == ackTick)
+            held -= ackHeldSeconds;
+        if (held > 0.f)
+            move(x, y, p.up, p.down, p.left, p.right, held);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef PREDICTION_HPP
+#define PREDICTION_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "../Protocol/Protocol.hpp"
+
+// Predicts where the local player's ship is, so it answers the keys at
+// once instead of a round trip later. Every sent input is kept with the
+// time it went out and moves the ship, with the game's movement rule,
+// until the next one. When a snapshot arrives with an INPUT_ACK, the
+// inputs the server has applied are dropped and the rest are replayed on
+// top of the server's position. Any difference to what was shown fades
+// out over CorrectionSeconds instead of snapping, unless it is large.
+// Without a movement rule nothing is predicted and the ship is shown where
+// the last snapshot put it.
+class LocalPrediction {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Moves a player at (x, y) holding the given directions for dt seconds.
+    // Must be the rule the server's game plugin applies.
+    using MoveRule = void (*)(float &x, float &y, bool up, bool down, bool left, bool right, float dt);
+
+    // About three seconds of inputs at the input send rate.
+    static constexpr size_t MaxPending = 64;
+    // Larger corrections, such as a respawn, are applied at once.
+    static constexpr float SnapDistance = 100.f;
+    // Time for a correction to decay to 1/e.
+    static constexpr float CorrectionSeconds = 0.1f;
+
+    explicit LocalPrediction(MoveRule move = nullptr) : move(move) {}
+
+    void onInputSent(const PlayerInputPayload &input, Clock::time_point now);
+    // The local player's state from a snapshot and the INPUT_ACK sent with
+    // it. Without an ack the state can only be used while nothing is
+    // pending.
+    void onServerState(float x, float y, const InputAckPayload* ack, Clock::time_point now);
+    // Where to draw the ship; false before the first server state.
+    bool position(Clock::time_point now, float &x, float &y) const;
+
+    size_t pendingInputs() const { return count; }
+    // Distance between the shown and the replayed position at the last
+    // server state, i.e. how wrong the prediction was.
+    float lastCorrection() const { return lastError; }
+
+private:
+    struct Pending {
+        uint32_t tick;
+        bool up, down, left, right;
+        Clock::time_point sentAt;
+    };
+    const Pending &at(size_t i) const { return pending[(first + i) % MaxPending]; }
+    void predict(Clock::time_point now, float &x, float &y) const;
+
+    MoveRule move;
+    Pending pending[MaxPending] = {};
+    size_t first = 0;
+    size_t count = 0;
+
+    // Last server position, and the input it already includes part of.
+    bool hasState = false;
+    float baseX = 0.f, baseY = 0.f;
+    uint32_t ackTick = 0;
+    float ackHeldSeconds = 0.f;
+
+    float correctionX = 0.f, correctionY = 0.f;
+    Clock::time_point correctionAt;
+    float lastError = 0.f;
+};
+
+#endif // PREDICTION_HPP
@@ -2,6 +2,7 @@
 #include <vector>
 #include <thread>
 #include <cstdlib>
+#include <string>
 #include <unistd.h>
 #include <dlfcn.h>
 
@@ -15,24 +16,51 @@
 #include "Protocol/Protocol.hpp"
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <port>\n";
+    bool useUring = false;
+    int shards = 0;
+    bool compress = true;
+    bool compressDeltas = false;
+    bool validArgs = argc >= 2;
+    for (int i = 2; i < argc && validArgs; i++) {
+        std::string arg = argv[i];
+        if (arg == "--io-uring")
+            useUring = true;
+        else if (arg == "--shards" && i + 1 < argc)
+            shards = std::atoi(argv[++i]);
+        else if (arg == "--no-compress")
+            compress = false;
+        else if (arg == "--compress-deltas")
+            compressDeltas = true;
+        else if (arg == "--stats")
+            reportClientStats = true;
+        else
+            validArgs = false;
+    }
+    if (!validArgs || shards < 0 || (useUring && shards > 0) || (!compress && compressDeltas)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <port> [--io-uring | --shards N] [--no-compress | --compress-deltas] [--stats]\n";
         return 1;
     }
+    if (!compress)
+        compression = CompressionPolicy{};
+    compression.enable(MessageType::GAME_STATE_DELTA, compressDeltas);
     int port = std::atoi(argv[1]);
-    int sock = initializeSocket(port);
+    int sock = initializeSocket(port, shards > 0);
 
     void* pluginHandle = nullptr;
     IGame* game = selectAndLoadPlugin(sock, &pluginHandle);
 
-    std::vector<sockaddr_in> clients;
-    std::thread clientThread(handleClientMessages, sock, std::ref(clients), game);
+    std::thread clientThread;
+    SocketBackend backend = serverSocket.open(sock, useUring ? SocketBackend::IoUring : SocketBackend::Batched);
+    if (backend == SocketBackend::Batched && !(shards > 0 && receiveShards.start(sock, static_cast<size_t>(shards), inputQueue)))
+        clientThread = std::thread(handleClientMessages, sock);
 
-    runGameLoop(sock, game, clients);
+    runGameLoop(game);
 
     delete game;
     dlclose(pluginHandle);
     close(sock);
-    clientThread.join();
+    if (clientThread.joinable())
+        clientThread.join();
     return 0;
 }